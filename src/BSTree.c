@@ -8,22 +8,68 @@
 #include <stdlib.h>
 
 #include "BSTree.h"
+#include "BSTreeExt.h"
+#include "Pool.h"
 
-#define data(tree)  ((tree)->data)
-#define left(tree)  ((tree)->left)
-#define right(tree) ((tree)->right)
+#define data(tree)   ((tree)->data)
+#define left(tree)   ((tree)->left)
+#define right(tree)  ((tree)->right)
+#define height(tree) ((tree)->height)
 
+// the tree is kept AVL balanced: the heights of every node's subtrees
+// differ by at most 1, so its height is below 1.45 log2(n + 2) whatever
+// order items arrive in. An int can hold fewer than 2^32 distinct items,
+// so no tree is ever as tall as this
+#define MAX_HEIGHT 64
+
+// searches run side by side by FrozenTreeContainsAll
+#define BATCH 16
+
+// items per cache line
+#define LINE_ITEMS (64 / (int)sizeof(Item))
+
+// every node of a tree comes from a pool (Pool.h) that holds that tree's
+// nodes and nothing else, found from the root with PoolOf. The functions
+// that return a tree record its root as the pool's owner, so freeing the
+// whole tree frees the pool; freeing a subtree gives just its nodes back,
+// and dropped nodes go back onto the free list
 typedef struct Node {
 	int  data;
+	int  height;  // of the subtree rooted here, 1 for a leaf
 	Tree left;
 	Tree right;
 } Node;
 
+// items[1] is the root, and the children of items[k] are items[2k] and
+// items[2k + 1]; items[0] is unused. Descending one level multiplies the
+// index by 2, so the items 4 levels down from k are the LINE_ITEMS
+// starting at items[LINE_ITEMS * k], one cache line
+struct FrozenTreeRep {
+	int size;
+	int levels;   // of the implicit tree
+	Item *items;
+};
+
+static Tree newNode(Pool p, Item it);
+static Pool treePool(Tree t);
+static Tree asRoot(Tree t);
+static int heightOf(Tree t);
+static void updateHeight(Tree t);
+static Tree rotateLeft(Tree t);
+static Tree rotateRight(Tree t);
+static Tree rebalance(Tree t);
+static int treeSize(Tree t);
+static void flatten(Tree t, Tree *nodes);
+static Tree build(Tree *nodes, int lo, int hi);
+static Tree *newNodeArray(int n);
+static int layout(const Item *sorted, Item *items, int i, int k, int n);
+static int lowerBound(FrozenTree f, Item it);
+
 // make a new node containing data
-static Tree newNode(Item it) {
-	Tree new = malloc(sizeof(Node));
-	assert(new != NULL);
+static Tree newNode(Pool p, Item it) {
+	Tree new = PoolAlloc(p);
 	data(new) = it;
+	height(new) = 1;
 	left(new) = right(new) = NULL;
 	return new;
 }
@@ -32,12 +78,36 @@ Tree TreeNew(void) {
 	return NULL;
 }
 
+// O(chunks) for a whole tree, O(size of t) for a subtree
+// a whole tree's pool goes at once, without visiting the nodes. A
+// subtree's nodes are given back one by one, and the pool goes with the
+// last of them
 void TreeFree(Tree t) {
-	if (t != NULL) {
-		TreeFree(left(t));
-		TreeFree(right(t));
-		free(t);
+	if (t == NULL) {
+		return;
+	}
+	Pool pool = PoolOf(t);
+	if (PoolOwner(pool) != t) {
+		// popping a node pushes its children, so the stack holds at most
+		// one node per level plus one
+		Tree stack[MAX_HEIGHT + 1];
+		int depth = 0;
+		stack[depth++] = t;
+		while (depth > 0) {
+			Tree node = stack[--depth];
+			if (left(node) != NULL) {
+				stack[depth++] = left(node);
+			}
+			if (right(node) != NULL) {
+				stack[depth++] = right(node);
+			}
+			PoolRelease(pool, node);
+		}
+		if (PoolNumLive(pool) > 0) {
+			return;
+		}
 	}
+	PoolFree(pool);
 }
 
 Tree TreeGetLeft(Tree t) {
@@ -54,15 +124,32 @@ Tree TreeGetRight(Tree t) {
 	return right(t);
 }
 
+// O(log n)
+// walks down remembering the links it followed, then back up them fixing
+// heights and rotating where a subtree has become unbalanced. Once a
+// subtree's height is unchanged nothing above it can have changed either
 Tree TreeInsert(Tree t, Item it) {
-	if (t == NULL) {
-		t = newNode(it);
-	} else if (it < data(t)) {
-		left(t) = TreeInsert(left(t), it);
-	} else if (it > data(t)) {
-		right(t) = TreeInsert(right(t), it);
+	Tree *path[MAX_HEIGHT];
+	int depth = 0;
+	Tree *link = &t;
+	while (*link != NULL) {
+		if (it == data(*link)) {
+			return t;
+		}
+		path[depth++] = link;
+		link = it < data(*link) ? &left(*link) : &right(*link);
 	}
-	return t;
+	*link = newNode(treePool(t), it);
+
+	while (depth > 0) {
+		link = path[--depth];
+		int before = height(*link);
+		*link = rebalance(*link);
+		if (height(*link) == before) {
+			break;
+		}
+	}
+	return asRoot(t);
 }
 
 void TreePrint(Tree t) {
@@ -83,14 +170,364 @@ void TreePrint(Tree t) {
 	TreePrint(right(t));
 }
 
+// O(|t1| + |t2|)
+// both trees are flattened in order and merged like two sorted lists.
+// t1's nodes are kept, and only the items it is missing get new nodes
 Tree TreeAdd(Tree t1, Tree t2) {
-	if (t2 == NULL) {
-		return t1;
+	int n1 = treeSize(t1);
+	int n2 = treeSize(t2);
+	Tree *a = newNodeArray(n1);
+	Tree *b = newNodeArray(n2);
+	Tree *out = newNodeArray(n1 + n2);
+	Pool pool = n2 > 0 ? treePool(t1) : NULL;
+	flatten(t1, a);
+	flatten(t2, b);
+
+	int i = 0;
+	int j = 0;
+	int n = 0;
+	while (i < n1 || j < n2) {
+		if (j == n2 || (i < n1 && data(a[i]) < data(b[j]))) {
+			out[n++] = a[i++];
+		} else if (i == n1 || data(b[j]) < data(a[i])) {
+			out[n++] = newNode(pool, data(b[j++]));
+		} else {
+			out[n++] = a[i++];
+			j++;
+		}
+	}
+
+	Tree t = build(out, 0, n);
+	free(a);
+	free(b);
+	free(out);
+	return asRoot(t);
+}
+
+// O(|t1| + |t2|)
+Tree TreeIntersect(Tree t1, Tree t2) {
+	int n1 = treeSize(t1);
+	int n2 = treeSize(t2);
+	Tree *a = newNodeArray(n1);
+	Tree *b = newNodeArray(n2);
+	Pool pool = n1 > 0 ? PoolOf(t1) : NULL;
+	flatten(t1, a);
+	flatten(t2, b);
+
+	// the kept nodes are packed to the front of a
+	int j = 0;
+	int n = 0;
+	for (int i = 0; i < n1; i++) {
+		while (j < n2 && data(b[j]) < data(a[i])) {
+			j++;
+		}
+		if (j < n2 && data(b[j]) == data(a[i])) {
+			a[n++] = a[i];
+		} else {
+			PoolRelease(pool, a[i]);
+		}
+	}
+	if (n == 0) {
+		PoolFree(pool);
+	}
+
+	Tree t = build(a, 0, n);
+	free(a);
+	free(b);
+	return asRoot(t);
+}
+
+// O(|t1| + |t2|)
+Tree TreeDifference(Tree t1, Tree t2) {
+	int n1 = treeSize(t1);
+	int n2 = treeSize(t2);
+	Tree *a = newNodeArray(n1);
+	Tree *b = newNodeArray(n2);
+	Pool pool = n1 > 0 ? PoolOf(t1) : NULL;
+	flatten(t1, a);
+	flatten(t2, b);
+
+	// the kept nodes are packed to the front of a
+	int j = 0;
+	int n = 0;
+	for (int i = 0; i < n1; i++) {
+		while (j < n2 && data(b[j]) < data(a[i])) {
+			j++;
+		}
+		if (j < n2 && data(b[j]) == data(a[i])) {
+			PoolRelease(pool, a[i]);
+		} else {
+			a[n++] = a[i];
+		}
+	}
+	if (n == 0) {
+		PoolFree(pool);
+	}
+
+	Tree t = build(a, 0, n);
+	free(a);
+	free(b);
+	return asRoot(t);
+}
+
+// O(n)
+Tree TreeFromSortedArray(const Item *items, int n) {
+	Tree *nodes = newNodeArray(n);
+	Pool pool = n > 0 ? PoolNew(sizeof(Node)) : NULL;
+	int numNodes = 0;
+	for (int i = 0; i < n; i++) {
+		assert(i == 0 || items[i - 1] <= items[i]);
+		if (i == 0 || items[i - 1] != items[i]) {
+			nodes[numNodes++] = newNode(pool, items[i]);
+		}
+	}
+	Tree t = build(nodes, 0, numNodes);
+	free(nodes);
+	return asRoot(t);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Frozen trees
+
+// O(n)
+FrozenTree TreeFreeze(Tree t) {
+	int n = treeSize(t);
+	Tree *nodes = newNodeArray(n);
+	Item *sorted = malloc((n > 0 ? n : 1) * sizeof(Item));
+	FrozenTree f = malloc(sizeof(*f));
+	// aligned so every LINE_ITEMS block is one cache line
+	size_t bytes = ((size_t)n + 1) * sizeof(Item);
+	bytes = (bytes + 63) / 64 * 64;
+	Item *items = aligned_alloc(64, bytes);
+	assert(sorted != NULL && f != NULL && items != NULL);
+
+	flatten(t, nodes);
+	for (int i = 0; i < n; i++) {
+		sorted[i] = data(nodes[i]);
+	}
+	layout(sorted, items, 0, 1, n);
+	items[0] = 0;
+	free(nodes);
+	free(sorted);
+
+	f->size = n;
+	f->items = items;
+	f->levels = 0;
+	while ((1L << f->levels) <= n) {
+		f->levels++;
 	}
+	return f;
+}
 
-	Tree t = TreeInsert(t1, data(t2));
-	t = TreeAdd(t, left(t2));
-	t = TreeAdd(t, right(t2));
+void FrozenTreeFree(FrozenTree f) {
+	if (f != NULL) {
+		free(f->items);
+		free(f);
+	}
+}
+
+int FrozenTreeSize(FrozenTree f) {
+	assert(f != NULL);
+	return f->size;
+}
+
+// O(log n)
+bool FrozenTreeContains(FrozenTree f, Item it) {
+	assert(f != NULL);
+	int k = lowerBound(f, it);
+	return k != 0 && f->items[k] == it;
+}
+
+// O(log n)
+bool FrozenTreeLowerBound(FrozenTree f, Item it, Item *result) {
+	assert(f != NULL);
+	int k = lowerBound(f, it);
+	if (k == 0) {
+		return false;
+	}
+	*result = f->items[k];
+	return true;
+}
+
+// O(n log size)
+// the searches of a batch go down the tree a level at a time together,
+// so the cache misses of one level are all waited for at once
+void FrozenTreeContainsAll(FrozenTree f, const Item *items, int n,
+                           bool *found) {
+	assert(f != NULL);
+	const Item *tree = f->items;
+	unsigned size = f->size;
+	for (int start = 0; start < n; start += BATCH) {
+		int count = n - start < BATCH ? n - start : BATCH;
+		unsigned k[BATCH];
+		for (int q = 0; q < count; q++) {
+			k[q] = 1;
+		}
+		for (int level = 0; level < f->levels; level++) {
+			for (int q = 0; q < count; q++) {
+				// a search that has gone past the bottom stays put
+				unsigned at = k[q] <= size ? k[q] : 0;
+				unsigned next = 2 * k[q] + (tree[at] < items[start + q]);
+				k[q] = k[q] <= size ? next : k[q];
+			}
+		}
+		for (int q = 0; q < count; q++) {
+			unsigned at = k[q] >> __builtin_ffs(~k[q]);
+			found[start + q] = at != 0 && tree[at] == items[start + q];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// Balancing
+
+static int heightOf(Tree t) {
+	return t == NULL ? 0 : height(t);
+}
+
+static void updateHeight(Tree t) {
+	int l = heightOf(left(t));
+	int r = heightOf(right(t));
+	height(t) = (l > r ? l : r) + 1;
+}
+
+// t's right child r takes its place, and t takes r's left subtree as
+// its new right subtree
+static Tree rotateLeft(Tree t) {
+	Tree r = right(t);
+	right(t) = left(r);
+	left(r) = t;
+	updateHeight(t);
+	updateHeight(r);
+	return r;
+}
+
+// the mirror image of rotateLeft
+static Tree rotateRight(Tree t) {
+	Tree l = left(t);
+	left(t) = right(l);
+	right(l) = t;
+	updateHeight(t);
+	updateHeight(l);
+	return l;
+}
+
+// restores the AVL condition at t, whose subtrees are balanced but may
+// differ in height by 2, and returns the new root of the subtree
+static Tree rebalance(Tree t) {
+	updateHeight(t);
+	int balance = heightOf(left(t)) - heightOf(right(t));
+	if (balance > 1) {
+		if (heightOf(left(left(t))) < heightOf(right(left(t)))) {
+			left(t) = rotateLeft(left(t));
+		}
+		return rotateRight(t);
+	} else if (balance < -1) {
+		if (heightOf(right(right(t))) < heightOf(left(right(t)))) {
+			right(t) = rotateRight(right(t));
+		}
+		return rotateLeft(t);
+	}
 	return t;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Flattening and rebuilding
+
+// O(n)
+static int treeSize(Tree t) {
+	Tree stack[MAX_HEIGHT];
+	int depth = 0;
+	int n = 0;
+	while (t != NULL || depth > 0) {
+		while (t != NULL) {
+			stack[depth++] = t;
+			t = left(t);
+		}
+		t = stack[--depth];
+		n++;
+		t = right(t);
+	}
+	return n;
+}
+
+// O(n)
+// fills nodes with the nodes of t, in order
+static void flatten(Tree t, Tree *nodes) {
+	Tree stack[MAX_HEIGHT];
+	int depth = 0;
+	int n = 0;
+	while (t != NULL || depth > 0) {
+		while (t != NULL) {
+			stack[depth++] = t;
+			t = left(t);
+		}
+		t = stack[--depth];
+		nodes[n++] = t;
+		t = right(t);
+	}
+}
+
+// O(hi - lo)
+// links nodes[lo] to nodes[hi - 1] into a perfectly balanced tree, which
+// is also a valid AVL tree, and returns its root
+static Tree build(Tree *nodes, int lo, int hi) {
+	if (lo >= hi) {
+		return NULL;
+	}
+	int mid = lo + (hi - lo) / 2;
+	Tree t = nodes[mid];
+	left(t) = build(nodes, lo, mid);
+	right(t) = build(nodes, mid + 1, hi);
+	updateHeight(t);
+	return t;
+}
+
+// the pool t's nodes come from, or a new one if t is empty
+static Pool treePool(Tree t) {
+	return t == NULL ? PoolNew(sizeof(Node)) : PoolOf(t);
+}
+
+// records t as the root of the whole tree, which TreeFree frees at once
+static Tree asRoot(Tree t) {
+	if (t != NULL) {
+		PoolSetOwner(PoolOf(t), t);
+	}
+	return t;
+}
+
+static Tree *newNodeArray(int n) {
+	Tree *nodes = malloc((n > 0 ? n : 1) * sizeof(Tree));
+	assert(nodes != NULL);
+	return nodes;
+}
+
+// O(n)
+// writes sorted[i...] into the subtree of items rooted at k, in order,
+// and returns the index of the next sorted item to place
+static int layout(const Item *sorted, Item *items, int i, int k, int n) {
+	if (k <= n) {
+		i = layout(sorted, items, i, 2 * k, n);
+		items[k] = sorted[i++];
+		i = layout(sorted, items, i, 2 * k + 1, n);
+	}
+	return i;
+}
+
+// O(log n)
+// returns the index of the smallest item >= it, or 0 if there is none
+// the loop has no branch on the comparison: going right is just adding
+// it to the index, and the line 4 levels down is fetched in advance.
+// Every right turn sets a low bit of k and the final left turn was onto
+// the answer, so stripping the trailing right turns (and that last step)
+// leaves its index
+static int lowerBound(FrozenTree f, Item it) {
+	const Item *items = f->items;
+	unsigned n = f->size;
+	unsigned k = 1;
+	while (k <= n) {
+		__builtin_prefetch(items + (size_t)LINE_ITEMS * k);
+		k = 2 * k + (items[k] < it);
+	}
+	return k >> __builtin_ffs(~k);
+}
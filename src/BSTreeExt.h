@@ -0,0 +1,52 @@
+// Binary Search Tree ADT interface extensions
+// COMP2521 Assignment 2
+
+// Set operations and frozen read only trees, added on top of BSTree.h,
+// which is fixed by the assignment and so left exactly as it was given.
+
+#ifndef BSTREE_EXT_H
+#define BSTREE_EXT_H
+
+#include <stdbool.h>
+
+#include "BSTree.h"
+
+// A read only copy of a tree's items, laid out for fast searching
+typedef struct FrozenTreeRep *FrozenTree;
+
+// The set operations below change t1 into the result, reusing its nodes
+// (and freeing those that are dropped), and leave t2 as it is. Each runs
+// in O(|t1| + |t2|) and returns a perfectly balanced tree. TreeAdd, in
+// BSTree.h, works the same way.
+
+// t1 without the items that aren't in t2
+Tree TreeIntersect(Tree t1, Tree t2);
+
+// t1 without the items that are in t2
+Tree TreeDifference(Tree t1, Tree t2);
+
+// A balanced tree of the n items, which must be in increasing order
+// (repeats are dropped), built in O(n)
+Tree TreeFromSortedArray(const Item *items, int n);
+
+// A frozen copy of the items in t, in O(n). The tree is left as it is.
+// Frozen trees store the items in one array in the order of a breadth
+// first walk (the Eytzinger layout), so a search reads memory in an order
+// the cache can predict instead of following pointers.
+FrozenTree TreeFreeze(Tree t);
+
+void FrozenTreeFree(FrozenTree f);
+
+int FrozenTreeSize(FrozenTree f);
+
+bool FrozenTreeContains(FrozenTree f, Item it);
+
+// Finds the smallest item that is >= it, returning false if there is none
+bool FrozenTreeLowerBound(FrozenTree f, Item it, Item *result);
+
+// Sets found[i] to whether items[i] is in f, for each of the n items.
+// Several searches are run side by side, so their memory reads overlap.
+void FrozenTreeContainsAll(FrozenTree f, const Item *items, int n,
+                           bool *found);
+
+#endif
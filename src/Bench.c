@@ -0,0 +1,717 @@
+// Benchmark driver with synthetic graph generators
+// COMP2521 Assignment 2
+
+// Build from the repository root with
+//     gcc -std=c11 -O2 -o bench src/*.c -lm -pthread
+//
+// Generate a graph in the format readGraph expects:
+//     ./bench -g rmat -n 4096 -d 8 -s 1 -w graph.txt
+// Time every operation on a generated graph and save the results:
+//     ./bench -g rmat -n 4096 -d 8 -s 1 -o base.json
+// Run again (after a change) and compare against the saved results,
+// exiting with status 1 if anything got slower than the tolerance:
+//     ./bench -g rmat -n 4096 -d 8 -s 1 -b base.json -t 0.1
+//
+// Built with -DGRAPH_STATS, the results also give the counters from
+// Stats.h for one run of each operation.
+//
+// Options
+//     -g generator   er, rmat, grid or complete (default er)
+//     -n vertices    number of vertices (default 1000), rounded to the
+//                    nearest size the generator can make
+//     -d degree      average number of outgoing edges (er, rmat)
+//     -W weight      edge weights are drawn from 1 to this (default 100)
+//     -s seed        generators and inputs are reproducible for a seed
+//     -r repeats     timed runs of each operation (default 11)
+//     -j threads     threads for the parallel algorithms (default one
+//                    per core)
+//     -f names       only run the operations whose names are listed,
+//                    separated by commas
+//     -w file        write the graph to file and stop
+//     -o file        write the JSON results to file instead of stdout
+//     -b file        compare against the results saved in file
+//     -t tolerance   a median more than this fraction above the baseline
+//                    is a regression (default 0.1)
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// math.h defines INFINITY as a float, Dijkstra.h needs it to be INT_MAX
+#undef INFINITY
+
+#include "BSTree.h"
+#include "BSTreeExt.h"
+#include "CentralityMeasures.h"
+#include "Dijkstra.h"
+#include "Graph.h"
+#include "GraphRead.h"
+#include "LanceWilliamsHAC.h"
+#include "LanceWilliamsHACExt.h"
+#include "Scheduler.h"
+#include "Stats.h"
+
+// HAC with the distance matrix (complete and average linkage) takes
+// O(nV^2) memory, so it is skipped above this. Single linkage and the
+// sparse versions only store the edges, and always run
+#define HAC_MAX_VERTICES 4096
+
+// average linkage with the matrix scans all of it for every merge, in
+// O(nV^3) time, so it is skipped above this
+#define HAC_SCAN_MAX_VERTICES 1024
+
+// the BSTree operations use at least this many items, so they take long
+// enough to time on small graphs
+#define MIN_ITEMS 65536
+
+// R-MAT quadrant probabilities (Chakrabarti et al.), the rest goes to the
+// bottom right quadrant
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+typedef struct options {
+	char *generator;
+	int numVertices;
+	double degree;
+	int maxWeight;
+	uint64_t seed;
+	int repeats;
+	int numThreads;
+	char *filter;
+	char *graphFile;
+	char *outFile;
+	char *baselineFile;
+	double tolerance;
+} Options;
+
+// everything an operation needs, made once before any timing starts
+typedef struct context {
+	Graph g;
+	long numEdges;
+	char *graphFile;  // g written out, for timing readGraph
+	Item *items;      // random items for the BSTree operations
+	int numItems;
+	uint64_t random;
+} Context;
+
+// times one run of an operation, leaving out its setup
+typedef double (*Operation)(Context *c, int repeat);
+
+typedef struct benchmark {
+	char *name;
+	Operation run;
+	char *unit;       // what 'items' counts
+	long items;       // work done by one run, for the throughput
+	bool skipped;
+	double median;    // seconds
+	double p99;
+	double baseline;  // the baseline's median, or -1 if it has none
+	Stats stats;      // counted over the warm up run
+} Benchmark;
+
+static Options parseOptions(int argc, char *argv[]);
+static void usage(char *name);
+static Graph generate(Options o);
+static void randomEdges(Graph g, long numEdges, int scale, Options o,
+                        uint64_t *random);
+static void gridEdges(Graph g, int side, Options o, uint64_t *random);
+static void writeGraph(Graph g, char *file);
+static long countEdges(Graph g);
+static bool selected(char *filter, char *name);
+static void measure(Benchmark *b, Context *c, int repeats);
+static double percentile(double *samples, int n, double p);
+static int doubleCompare(const void *a, const void *b);
+static double baselineMedian(char *json, char *name);
+static void checkBaselineGraph(char *json, Context *c);
+static char *readFile(char *file);
+static void writeResults(FILE *fp, Options o, Context *c, Benchmark *b,
+                         int n);
+static void writeStats(FILE *fp, Stats stats);
+static uint64_t nextRandom(uint64_t *state);
+static int randomBelow(uint64_t *state, int n);
+static double now(void);
+
+static double timeReadGraph(Context *c, int repeat);
+static double timeDijkstra(Context *c, int repeat);
+static double timeCloseness(Context *c, int repeat);
+static double timeBetweenness(Context *c, int repeat);
+static double timeHAC(Context *c, int repeat);
+static double timeHACComplete(Context *c, int repeat);
+static double timeHACAverage(Context *c, int repeat);
+static double timeHACSparseComplete(Context *c, int repeat);
+static double timeHACSparseAverage(Context *c, int repeat);
+static double timeLinkage(Context *c, int method, bool sparse);
+static long maxVertices(Operation run);
+static double timeTreeInsert(Context *c, int repeat);
+static double timeTreeAdd(Context *c, int repeat);
+static double timeFrozenContains(Context *c, int repeat);
+
+int main(int argc, char *argv[]) {
+	Options o = parseOptions(argc, argv);
+	SchedulerSetThreads(o.numThreads);
+	Graph g = generate(o);
+	if (o.graphFile != NULL) {
+		writeGraph(g, o.graphFile);
+		GraphFree(g);
+		return EXIT_SUCCESS;
+	}
+
+	Context c;
+	c.g = g;
+	c.numEdges = countEdges(g);
+	c.random = o.seed;
+	char graphFile[] = "/tmp/benchGraphXXXXXX";
+	int fd = mkstemp(graphFile);
+	if (fd == -1) {
+		fprintf(stderr, "error: couldn't create a temporary file\n");
+		exit(EXIT_FAILURE);
+	}
+	close(fd);
+	c.graphFile = graphFile;
+	writeGraph(g, graphFile);
+	c.numItems = GraphNumVertices(g) > MIN_ITEMS ? GraphNumVertices(g)
+	                                             : MIN_ITEMS;
+	c.items = malloc(c.numItems * sizeof(Item));
+	if (c.items == NULL) {
+		fprintf(stderr, "Couldn't allocate items!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < c.numItems; i++) {
+		c.items[i] = randomBelow(&c.random, 4 * c.numItems);
+	}
+
+	long nV = GraphNumVertices(g);
+	// name, operation, unit and items, with the results filled in later
+	Benchmark b[] = {
+		{"readGraph", timeReadGraph, "edges", c.numEdges, 0, 0, 0, 0, {0}},
+		{"dijkstra", timeDijkstra, "edges", c.numEdges, 0, 0, 0, 0, {0}},
+		{"closenessCentrality", timeCloseness, "edges", nV * c.numEdges,
+		 0, 0, 0, 0, {0}},
+		{"betweennessCentrality", timeBetweenness, "edges", nV * c.numEdges,
+		 0, 0, 0, 0, {0}},
+		{"LanceWilliamsHAC", timeHAC, "pairs", nV * (nV - 1) / 2,
+		 0, 0, 0, 0, {0}},
+		{"LanceWilliamsHACComplete", timeHACComplete, "pairs",
+		 nV * (nV - 1) / 2, 0, 0, 0, 0, {0}},
+		{"LanceWilliamsHACAverage", timeHACAverage, "pairs",
+		 nV * (nV - 1) / 2, 0, 0, 0, 0, {0}},
+		{"LanceWilliamsHACSparseComplete", timeHACSparseComplete, "edges",
+		 c.numEdges, 0, 0, 0, 0, {0}},
+		{"LanceWilliamsHACSparseAverage", timeHACSparseAverage, "edges",
+		 c.numEdges, 0, 0, 0, 0, {0}},
+		{"TreeInsert", timeTreeInsert, "items", c.numItems, 0, 0, 0, 0, {0}},
+		{"TreeAdd", timeTreeAdd, "items", 2L * c.numItems, 0, 0, 0, 0, {0}},
+		{"FrozenTreeContainsAll", timeFrozenContains, "items", c.numItems,
+		 0, 0, 0, 0, {0}},
+	};
+	int numBenchmarks = sizeof(b) / sizeof(b[0]);
+
+	char *baseline = o.baselineFile != NULL ? readFile(o.baselineFile) : NULL;
+	if (baseline != NULL) {
+		checkBaselineGraph(baseline, &c);
+	}
+	bool regressed = false;
+	for (int i = 0; i < numBenchmarks; i++) {
+		b[i].skipped = !selected(o.filter, b[i].name) ||
+		               nV > maxVertices(b[i].run);
+		b[i].baseline = -1;
+		if (b[i].skipped) {
+			continue;
+		}
+		measure(&b[i], &c, o.repeats);
+		if (baseline != NULL) {
+			b[i].baseline = baselineMedian(baseline, b[i].name);
+		}
+		if (b[i].baseline > 0 &&
+		    b[i].median > b[i].baseline * (1 + o.tolerance)) {
+			fprintf(stderr, "regression: %s took %.3f ms, baseline %.3f ms "
+			        "(%+.1f%%)\n", b[i].name, b[i].median * 1e3,
+			        b[i].baseline * 1e3,
+			        (b[i].median / b[i].baseline - 1) * 100);
+			regressed = true;
+		}
+	}
+
+	FILE *fp = stdout;
+	if (o.outFile != NULL) {
+		fp = fopen(o.outFile, "w");
+		if (fp == NULL) {
+			fprintf(stderr, "error: couldn't open %s for writing\n",
+			        o.outFile);
+			exit(EXIT_FAILURE);
+		}
+	}
+	writeResults(fp, o, &c, b, numBenchmarks);
+	if (fp != stdout) {
+		fclose(fp);
+	}
+
+	remove(graphFile);
+	free(baseline);
+	free(c.items);
+	GraphFree(g);
+	return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+static Options parseOptions(int argc, char *argv[]) {
+	Options o = {"er", 1000, 8, 100, 1, 11, 0, NULL, NULL, NULL, NULL, 0.1};
+	int opt;
+	while ((opt = getopt(argc, argv, "g:n:d:W:s:r:j:f:w:o:b:t:")) != -1) {
+		switch (opt) {
+			case 'g': o.generator = optarg; break;
+			case 'n': o.numVertices = atoi(optarg); break;
+			case 'd': o.degree = atof(optarg); break;
+			case 'W': o.maxWeight = atoi(optarg); break;
+			case 's': o.seed = strtoull(optarg, NULL, 10); break;
+			case 'r': o.repeats = atoi(optarg); break;
+			case 'j': o.numThreads = atoi(optarg); break;
+			case 'f': o.filter = optarg; break;
+			case 'w': o.graphFile = optarg; break;
+			case 'o': o.outFile = optarg; break;
+			case 'b': o.baselineFile = optarg; break;
+			case 't': o.tolerance = atof(optarg); break;
+			default: usage(argv[0]);
+		}
+	}
+	if (o.numVertices < 1 || o.degree < 0 || o.maxWeight < 1 ||
+	    o.repeats < 1 || o.numThreads < 0 || optind != argc) {
+		usage(argv[0]);
+	}
+	return o;
+}
+
+static void usage(char *name) {
+	fprintf(stderr, "usage: %s [-g er|rmat|grid|complete] [-n vertices] "
+	        "[-d degree] [-W maxWeight] [-s seed] [-r repeats] [-j threads] "
+	        "[-f names] [-w graphFile] [-o out.json] [-b baseline.json] "
+	        "[-t tolerance]\n", name);
+	exit(EXIT_FAILURE);
+}
+
+// makes the graph the options describe, the same one every time for the
+// same options
+static Graph generate(Options o) {
+	uint64_t random = o.seed;
+	int n = o.numVertices;
+	Graph g;
+	if (strcmp(o.generator, "er") == 0) {
+		// Erdős–Rényi G(n, m): m edges between uniformly random pairs
+		g = GraphNew(n);
+		randomEdges(g, (long)(n * o.degree), -1, o, &random);
+	} else if (strcmp(o.generator, "rmat") == 0) {
+		// R-MAT: a power law graph on the next power of 2 vertices
+		int scale = 0;
+		while ((1 << scale) < n) {
+			scale++;
+		}
+		g = GraphNew(1 << scale);
+		randomEdges(g, (long)((1 << scale) * o.degree), scale, o, &random);
+	} else if (strcmp(o.generator, "grid") == 0) {
+		// road like: a square grid with roads both ways between
+		// neighbours, on the nearest square number of vertices
+		int side = (int)round(sqrt(n));
+		side = side > 0 ? side : 1;
+		g = GraphNew(side * side);
+		gridEdges(g, side, o, &random);
+	} else if (strcmp(o.generator, "complete") == 0) {
+		g = GraphNew(n);
+		for (Vertex v = 0; v < n; v++) {
+			for (Vertex w = 0; w < n; w++) {
+				if (v != w) {
+					GraphInsertEdge(g, v, w,
+					                1 + randomBelow(&random, o.maxWeight));
+				}
+			}
+		}
+	} else {
+		fprintf(stderr, "error: unknown generator %s\n", o.generator);
+		exit(EXIT_FAILURE);
+	}
+	return g;
+}
+
+// tries to add numEdges edges, drawing the ends uniformly if scale is -1
+// and otherwise by R-MAT's recursive choice of quadrant on a 2^scale
+// matrix. Self loops and repeated edges are dropped rather than redrawn
+static void randomEdges(Graph g, long numEdges, int scale, Options o,
+                        uint64_t *random) {
+	int nV = GraphNumVertices(g);
+	for (long e = 0; e < numEdges; e++) {
+		Vertex v = 0;
+		Vertex w = 0;
+		if (scale < 0) {
+			v = randomBelow(random, nV);
+			w = randomBelow(random, nV);
+		} else {
+			for (int bit = 0; bit < scale; bit++) {
+				double p = (nextRandom(random) >> 11) * 0x1.0p-53;
+				v = 2 * v + (p >= RMAT_A + RMAT_B);
+				w = 2 * w + ((p >= RMAT_A && p < RMAT_A + RMAT_B) ||
+				             p >= RMAT_A + RMAT_B + RMAT_C);
+			}
+		}
+		if (v != w) {
+			GraphInsertEdge(g, v, w, 1 + randomBelow(random, o.maxWeight));
+		}
+	}
+}
+
+// O(side^2)
+static void gridEdges(Graph g, int side, Options o, uint64_t *random) {
+	for (int row = 0; row < side; row++) {
+		for (int col = 0; col < side; col++) {
+			Vertex v = row * side + col;
+			if (col + 1 < side) {
+				int weight = 1 + randomBelow(random, o.maxWeight);
+				GraphInsertEdge(g, v, v + 1, weight);
+				GraphInsertEdge(g, v + 1, v, weight);
+			}
+			if (row + 1 < side) {
+				int weight = 1 + randomBelow(random, o.maxWeight);
+				GraphInsertEdge(g, v, v + side, weight);
+				GraphInsertEdge(g, v + side, v, weight);
+			}
+		}
+	}
+}
+
+// writes g in the format readGraph reads
+static void writeGraph(Graph g, char *file) {
+	FILE *fp = fopen(file, "w");
+	if (fp == NULL) {
+		fprintf(stderr, "error: couldn't open %s for writing\n", file);
+		exit(EXIT_FAILURE);
+	}
+	fprintf(fp, "%d\n", GraphNumVertices(g));
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+			fprintf(fp, "%d,%d,%d\n", v, out->v, out->weight);
+		}
+	}
+	fclose(fp);
+}
+
+static long countEdges(Graph g) {
+	long numEdges = 0;
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+			numEdges++;
+		}
+	}
+	return numEdges;
+}
+
+// whether name is one of the comma separated names in filter, with no
+// filter selecting everything
+static bool selected(char *filter, char *name) {
+	if (filter == NULL) {
+		return true;
+	}
+	size_t length = strlen(name);
+	for (char *s = filter; (s = strstr(s, name)) != NULL; s++) {
+		if ((s == filter || s[-1] == ',') &&
+		    (s[length] == '\0' || s[length] == ',')) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// runs the operation once to warm up, then times it 'repeats' times
+static void measure(Benchmark *b, Context *c, int repeats) {
+	double *samples = malloc(repeats * sizeof(double));
+	if (samples == NULL) {
+		fprintf(stderr, "Couldn't allocate samples!\n");
+		exit(EXIT_FAILURE);
+	}
+	StatsScope scope = StatsBegin();
+	b->run(c, -1);
+	b->stats = StatsEnd(scope);
+	for (int i = 0; i < repeats; i++) {
+		samples[i] = b->run(c, i);
+	}
+	qsort(samples, repeats, sizeof(double), doubleCompare);
+	b->median = percentile(samples, repeats, 0.5);
+	b->p99 = percentile(samples, repeats, 0.99);
+	free(samples);
+}
+
+// the nearest rank percentile of the sorted samples
+static double percentile(double *samples, int n, double p) {
+	int rank = (int)ceil(p * n);
+	return samples[rank > 0 ? rank - 1 : 0];
+}
+
+static int doubleCompare(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+// finds the median a file written by writeResults gave for name, in
+// seconds, or -1 if it has none
+static double baselineMedian(char *json, char *name) {
+	char key[256];
+	snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+	char *s = strstr(json, key);
+	double median;
+	if (s == NULL || (s = strstr(s, "\"median_ms\":")) == NULL ||
+	    sscanf(s, "\"median_ms\": %lf", &median) != 1) {
+		return -1;
+	}
+	return median / 1e3;
+}
+
+// warns if the baseline was measured on a different graph, as its times
+// can't be compared then
+static void checkBaselineGraph(char *json, Context *c) {
+	char *vertices = strstr(json, "\"vertices\":");
+	char *edges = strstr(json, "\"edges\":");
+	int nV;
+	long numEdges;
+	if (vertices == NULL || edges == NULL ||
+	    sscanf(vertices, "\"vertices\": %d", &nV) != 1 ||
+	    sscanf(edges, "\"edges\": %ld", &numEdges) != 1 ||
+	    nV != GraphNumVertices(c->g) || numEdges != c->numEdges) {
+		fprintf(stderr, "warning: the baseline was measured on a "
+		        "different graph\n");
+	}
+}
+
+static char *readFile(char *file) {
+	FILE *fp = fopen(file, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "error: couldn't open %s for reading\n", file);
+		exit(EXIT_FAILURE);
+	}
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	rewind(fp);
+	char *text = malloc(size + 1);
+	if (text == NULL) {
+		fprintf(stderr, "Couldn't allocate file buffer!\n");
+		exit(EXIT_FAILURE);
+	}
+	text[fread(text, 1, size, fp)] = '\0';
+	fclose(fp);
+	return text;
+}
+
+static void writeResults(FILE *fp, Options o, Context *c, Benchmark *b,
+                         int n) {
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"graph\": {\"generator\": \"%s\", \"vertices\": %d, "
+	        "\"edges\": %ld, \"maxWeight\": %d, \"seed\": %llu},\n",
+	        o.generator, GraphNumVertices(c->g), c->numEdges, o.maxWeight,
+	        (unsigned long long)o.seed);
+	fprintf(fp, "  \"repeats\": %d,\n", o.repeats);
+	fprintf(fp, "  \"threads\": %d,\n", SchedulerNumThreads());
+	fprintf(fp, "  \"results\": [");
+	bool first = true;
+	for (int i = 0; i < n; i++) {
+		if (b[i].skipped) {
+			continue;
+		}
+		fprintf(fp, "%s\n    {\"name\": \"%s\", \"median_ms\": %.6f, "
+		        "\"p99_ms\": %.6f, \"throughput\": %.6g, \"unit\": \"%s/s\"",
+		        first ? "" : ",", b[i].name, b[i].median * 1e3,
+		        b[i].p99 * 1e3,
+		        b[i].median > 0 ? b[i].items / b[i].median : 0, b[i].unit);
+		if (b[i].baseline > 0) {
+			fprintf(fp, ", \"baseline_ms\": %.6f, \"change\": %.4f, "
+			        "\"regression\": %s", b[i].baseline * 1e3,
+			        b[i].median / b[i].baseline - 1,
+			        b[i].median > b[i].baseline * (1 + o.tolerance) ?
+			        "true" : "false");
+		}
+		if (b[i].stats.enabled) {
+			writeStats(fp, b[i].stats);
+		}
+		fprintf(fp, "}");
+		first = false;
+	}
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+static void writeStats(FILE *fp, Stats stats) {
+	fprintf(fp, ", \"stats\": {");
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		fprintf(fp, "%s\"%s\": %ld", i > 0 ? ", " : "",
+		        StatsCounterName(i), stats.counts[i]);
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		fprintf(fp, ", \"%s_ms\": %.6f", StatsPhaseName(i),
+		        stats.seconds[i] * 1e3);
+	}
+	fprintf(fp, "}");
+}
+
+// splitmix64
+static uint64_t nextRandom(uint64_t *state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static int randomBelow(uint64_t *state, int n) {
+	return (int)(nextRandom(state) % (uint64_t)n);
+}
+
+// seconds since some fixed point
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Operations
+// Each returns the time taken by the call being measured, and a repeat
+// of -1 is the warm up run
+
+static double timeReadGraph(Context *c, int repeat) {
+	(void)repeat;
+	double start = now();
+	Graph g = readGraph(c->graphFile);
+	double elapsed = now() - start;
+	GraphFree(g);
+	return elapsed;
+}
+
+// each repeat starts from a different source
+static double timeDijkstra(Context *c, int repeat) {
+	Vertex src = (repeat + 1) % GraphNumVertices(c->g);
+	double start = now();
+	ShortestPaths sps = dijkstra(c->g, src);
+	double elapsed = now() - start;
+	freeShortestPaths(sps);
+	return elapsed;
+}
+
+static double timeCloseness(Context *c, int repeat) {
+	(void)repeat;
+	double start = now();
+	NodeValues nvs = closenessCentrality(c->g);
+	double elapsed = now() - start;
+	freeNodeValues(nvs);
+	return elapsed;
+}
+
+static double timeBetweenness(Context *c, int repeat) {
+	(void)repeat;
+	double start = now();
+	NodeValues nvs = betweennessCentrality(c->g);
+	double elapsed = now() - start;
+	freeNodeValues(nvs);
+	return elapsed;
+}
+
+static double timeHAC(Context *c, int repeat) {
+	(void)repeat;
+	return timeLinkage(c, SINGLE_LINKAGE, false);
+}
+
+static double timeHACComplete(Context *c, int repeat) {
+	(void)repeat;
+	return timeLinkage(c, COMPLETE_LINKAGE, false);
+}
+
+static double timeHACAverage(Context *c, int repeat) {
+	(void)repeat;
+	return timeLinkage(c, AVERAGE_LINKAGE, false);
+}
+
+static double timeHACSparseComplete(Context *c, int repeat) {
+	(void)repeat;
+	return timeLinkage(c, COMPLETE_LINKAGE, true);
+}
+
+static double timeHACSparseAverage(Context *c, int repeat) {
+	(void)repeat;
+	return timeLinkage(c, AVERAGE_LINKAGE, true);
+}
+
+// one run of LanceWilliamsHAC, or LanceWilliamsHACSparse if sparse
+static double timeLinkage(Context *c, int method, bool sparse) {
+	double start = now();
+	Dendrogram d = sparse ? LanceWilliamsHACSparse(c->g, method)
+	                      : LanceWilliamsHAC(c->g, method);
+	double elapsed = now() - start;
+	freeDendrogram(d);
+	return elapsed;
+}
+
+// the largest graph an operation is run on
+static long maxVertices(Operation run) {
+	if (run == timeHACComplete) {
+		return HAC_MAX_VERTICES;
+	} else if (run == timeHACAverage) {
+		return HAC_SCAN_MAX_VERTICES;
+	}
+	return LONG_MAX;
+}
+
+static double timeTreeInsert(Context *c, int repeat) {
+	(void)repeat;
+	double start = now();
+	Tree t = TreeNew();
+	for (int i = 0; i < c->numItems; i++) {
+		t = TreeInsert(t, c->items[i]);
+	}
+	double elapsed = now() - start;
+	TreeFree(t);
+	return elapsed;
+}
+
+// adds a tree of the odd items to one of the even items
+static double timeTreeAdd(Context *c, int repeat) {
+	(void)repeat;
+	Tree t1 = TreeNew();
+	Tree t2 = TreeNew();
+	for (int i = 0; i < c->numItems; i++) {
+		t1 = TreeInsert(t1, 2 * c->items[i]);
+		t2 = TreeInsert(t2, 2 * c->items[i] + 1);
+	}
+	double start = now();
+	t1 = TreeAdd(t1, t2);
+	double elapsed = now() - start;
+	TreeFree(t1);
+	TreeFree(t2);
+	return elapsed;
+}
+
+// looks up every item, in a tree holding about half of them
+static double timeFrozenContains(Context *c, int repeat) {
+	(void)repeat;
+	Tree t = TreeNew();
+	for (int i = 0; i < c->numItems; i += 2) {
+		t = TreeInsert(t, c->items[i]);
+	}
+	FrozenTree f = TreeFreeze(t);
+	bool *found = malloc(c->numItems * sizeof(bool));
+	if (found == NULL) {
+		fprintf(stderr, "Couldn't allocate results!\n");
+		exit(EXIT_FAILURE);
+	}
+	double start = now();
+	FrozenTreeContainsAll(f, c->items, c->numItems, found);
+	double elapsed = now() - start;
+	free(found);
+	FrozenTreeFree(f);
+	TreeFree(t);
+	return elapsed;
+}
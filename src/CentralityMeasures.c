@@ -1,32 +1,157 @@
 // Centrality Measures API implementation
 // COMP2521 Assignment 2
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+
+// math.h defines INFINITY as a float, Dijkstra.h needs it to be INT_MAX
+#undef INFINITY
 
 #include "CentralityMeasures.h"
+#include "CentralityMeasuresExt.h"
+#include "CompactGraph.h"
+#include "Components.h"
 #include "Dijkstra.h"
 #include "PQ.h"
+#include "SSSP.h"
+#include "Scheduler.h"
+#include "Stats.h"
+
+// the grain of the parallel loops over sources
+#define REACH_CHUNK 16
+// sources searched together by one bit parallel BFS, one per bit
+#define BFS_BATCH 64
+// weakly connected components of at least this many nodes have their
+// sources split across threads for betweenness, in this many blocks
+#define BETWEENNESS_SPLIT 256
+#define BETWEENNESS_BLOCKS 32
+// the most strongly connected components reachLimits keeps the exact
+// descendants of, one bit per pair
+#define REACH_EXACT_COMPONENTS 8192
+
+// seed used by betweennessCentralityApprox
+#define APPROX_DEFAULT_SEED 2521
+// the constant c in the Riondato & Kornaropoulos sample size bound
+#define RK_CONSTANT 0.5
+
+// Shortest path counts grow exponentially on lattice-like graphs, so they
+// are kept as doubles, which lose precision instead of wrapping around.
+// Compile with -DCENTRALITY_EXACT_PATHS to count them exactly in 128 bits
+#ifdef CENTRALITY_EXACT_PATHS
+__extension__ typedef unsigned __int128 PathCount;
+#else
+typedef double PathCount;
+#endif
+
+// a node reached by dijkstra and its distance from the src
+typedef struct settled {
+	Vertex v;
+	int dist;
+} Settled;
+
+// what one src node can reach, which is all closeness needs
+typedef struct reach {
+	int numVisited;     // including the src itself
+	double sumDistance;
+	double harmonic;    // sum of 1 / distance
+} Reach;
+
+// a node and some score to rank it by, higher first
+typedef struct ranked {
+	Vertex v;
+	double value;
+} Ranked;
+
+// what one worker needs for the bit parallel BFS
+typedef struct bfsWorkspace {
+	uint64_t *visited;
+	uint64_t *frontier;
+	uint64_t *next;
+	Vertex *curr;
+	Vertex *found;
+} BFSWorkspace;
 
-// struct that makes everything look nicer
-// :)
-typedef struct path {
-	Vertex src;
-	Vertex middle;
-	Vertex dest;
-} Path;
+// shared by the worker threads of reachAll
+// the workspaces are indexed by SchedulerWorkerId, and each is made the
+// first time that worker runs a task
+typedef struct reachJob {
+	CompactGraph cg;
+	int unitWeight;     // the weight of every edge, or 0 if they differ
+	Components wcc;     // only found for the BFS, whose batches are taken
+	                    // from wcc.members so they share components
+	Reach *reach;
+	SSSP *sssp;
+	BFSWorkspace *bfs;
+} ReachJob;
 
+// shared by the worker threads of computeCentralities, with the same
+// per worker arrays as ReachJob
+typedef struct fusedJob {
+	CompactGraph cg;
+	Reach *reach;
+	SSSP *sssp;
+	double **partial;   // each worker's own betweenness sums
+	double **delta;
+} FusedJob;
 
-static double calCloseness(double distanceSum, int numVisted, int nV);
-static NodeValues createNodeValues(int numNodes);
-static bool pathCheck(Path p);
-static double calBetweeness(ShortestPaths sps, Path p);
-static int numPaths(ShortestPaths sps, Path p);
-static int numPathFinder(ShortestPaths sps, Path p);
+// shared by the worker threads of betweennessCentrality, each of which
+// works on whole weakly connected components, or on a block of the
+// sources of a large one, with the same per worker arrays as ReachJob
+typedef struct betweennessJob {
+	Graph g;
+	Components wcc;
+	NodeValues nvs;
+	CompactGraph cg;    // only taken if some component is large
+	SSSP *sssp;
+	double **delta;
+} BetweennessJob;
 
+// one large weakly connected component whose sources are being split
+typedef struct componentSources {
+	BetweennessJob *job;
+	int component;
+} ComponentSources;
 
-// O(n^3)
+
+static int countPaths(ShortestPaths sps, Settled *order, PathCount *numPaths);
+static PathCount addPaths(PathCount x, PathCount y);
+static int settledCompare(const void *a, const void *b);
+static double sampleBound(int nV, double delta);
+static void samplePath(SSSP s, Graph g, Vertex dest, double *values,
+                       uint64_t *state);
+static uint64_t nextRandom(uint64_t *state);
+static double wallTime(void);
+static double closenessBound(SSSP s, double sumDistance, int minWeight,
+                             int maxReach, int nV);
+static double boundAt(int total, int reached, double sumDistance,
+                      double nextDist, int nV);
+static int minimumWeight(Graph g);
+static int *reachLimits(Graph g, Components scc);
+static void topKOffer(TopKValues *tkv, int k, Vertex v, double value);
+static bool rankedWorse(Vertex v1, double value1, Vertex v2, double value2);
+static int rankedCompare(const void *a, const void *b);
+static Reach *reachAll(Graph g);
+static void reachSources(void *arg, int lo, int hi);
+static void reachBatches(void *arg, int lo, int hi);
+static inline __attribute__((always_inline))
+void reachBFSBatch(ReachJob *job, const Vertex *sources, int count,
+                   BFSWorkspace *w, int vertexBytes, int weightBytes);
+static void fusedSources(void *arg, int lo, int hi);
+static void betweennessComponents(void *arg, int lo, int hi);
+static void componentBetweenness(Graph g, double *values);
+static void splitBetweenness(BetweennessJob *job, int i);
+static void betweennessSources(void *arg, int lo, int hi, double *partial);
+static int uniformWeight(Graph g);
+
+
+// O(V * (V + E) log V), or O(V * E / 64) on graphs where every edge
+// has the same weight, split across all cores
 // This function calculates the closeness of centrality of every node in a graph
 // While using a Wasserman and Faust formula on a directed graph
 // Closeness is a measure of how long it would take for information to spread from the 
@@ -37,79 +162,217 @@ NodeValues closenessCentrality(Graph g) {
 	}
 	int nV = GraphNumVertices(g);
 	NodeValues nvs = createNodeValues(nV);
-	// looping through all nodes of the graph
+	Reach *reach = reachAll(g);
 	for(int i = 0; i < nV; i++) {
-		// running the shortest path algo on the g from src vertex: i
-		ShortestPaths sps = dijkstra(g, i);
-		// finding num of nodes reached and sum of distances
-		int numVisted = 1; // as src node is reached
-		double sumDistance = 0;
-		
-		for(int j = 0; j < nV; j++) {
-			// checking that the node isn't src or unreachable
-			if(sps.dist[j] != 0 && sps.dist[j] != INFINITY) {
-				numVisted++;
-				sumDistance = sumDistance + sps.dist[j];
-			}
-			
-		}
-		// checking if the node has no edges to it
-		AdjList in = GraphInIncident(g,i);
-		AdjList out = GraphOutIncident(g, i);
-		
-		// the specific cases don't really need to be checked
-		// as the nvs.value is calloced, and closeness will return 0
-		// just to be safe
-		if (in == NULL && out == NULL) {
-			nvs.values[i] = 0;
-		} else if (sumDistance == 0) { // if the node is the src
-			nvs.values[i] = 0;
-		} else { // calculating the closeness
-			nvs.values[i] = calCloseness(sumDistance, numVisted, nV);
+		// an isolated node or one that reaches nothing has closeness 0
+		if (reach[i].sumDistance != 0) {
+			nvs.values[i] = calCloseness(reach[i].sumDistance,
+			                             reach[i].numVisited, nV);
 		}
-		freeShortestPaths(sps);
 	}
+	free(reach);
 	return nvs;
 }
 
-// O(n^4)
+// Same cost as closenessCentrality
+// Harmonic centrality sums 1 / distance over every node the src reaches,
+// so unreachable nodes just add nothing instead of needing a special case
+NodeValues harmonicCentrality(Graph g) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	int nV = GraphNumVertices(g);
+	NodeValues nvs = createNodeValues(nV);
+	Reach *reach = reachAll(g);
+	for(int i = 0; i < nV; i++) {
+		nvs.values[i] = reach[i].harmonic;
+	}
+	free(reach);
+	return nvs;
+}
+
+// computes both measures from the same set of shortest path searches
+void closenessHarmonicCentrality(Graph g, NodeValues *closeness,
+                                 NodeValues *harmonic) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	int nV = GraphNumVertices(g);
+	*closeness = createNodeValues(nV);
+	*harmonic = createNodeValues(nV);
+	Reach *reach = reachAll(g);
+	for(int i = 0; i < nV; i++) {
+		if (reach[i].sumDistance != 0) {
+			closeness->values[i] = calCloseness(reach[i].sumDistance,
+			                                    reach[i].numVisited, nV);
+		}
+		harmonic->values[i] = reach[i].harmonic;
+	}
+	free(reach);
+}
+
+// O(V * (V + E) log V) in the worst case, usually far less
+// The searches are run from the highest out degree down, as those nodes
+// tend to be the most central and so raise the k-th best value quickly.
+// Every time a node is settled, closenessBound gives the best closeness
+// the src could still end up with; once that is below the k-th best
+// value found so far the rest of the search can't matter
+// A search can only reach the strongly connected components below its
+// src's in the condensation, so their total size (reachLimits) caps how
+// many nodes it can end up reaching, which tightens the bound
+TopKValues closenessTopK(Graph g, int k) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	int nV = GraphNumVertices(g);
+	if (k > nV) {
+		k = nV;
+	} else if (k < 0) {
+		k = 0;
+	}
+
+	TopKValues tkv;
+	tkv.k = 0;
+	tkv.vertices = malloc(nV * sizeof(Vertex));
+	tkv.values = malloc(nV * sizeof(double));
+	tkv.numSettled = 0;
+	if (tkv.vertices == NULL || tkv.values == NULL) {
+		fprintf(stderr, "Couldn't allocate top k arrays!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	Ranked *sources = malloc(nV * sizeof(Ranked));
+	if (sources == NULL) {
+		fprintf(stderr, "Couldn't allocate source order!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (Vertex v = 0; v < nV; v++) {
+		int degree = 0;
+		for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+			degree++;
+		}
+		sources[v] = (Ranked) {v, degree};
+	}
+	qsort(sources, nV, sizeof(Ranked), rankedCompare);
+
+	int minWeight = minimumWeight(g);
+	Components scc = stronglyConnectedComponents(g);
+	int *maxReach = reachLimits(g, scc);
+	SSSP s = SSSPNew(nV);
+	for (int i = 0; i < nV && k > 0; i++) {
+		Vertex src = sources[i].v;
+		// tkv.values[0] is the worst of the current top k
+		double kth = tkv.k == k ? tkv.values[0] : -1;
+		double sumDistance = 0;
+		bool pruned = false;
+		int limit = maxReach[scc.component[src]];
+
+		SSSPStart(s, src);
+		Vertex v;
+		while ((v = SSSPSettleNext(s, g)) != -1) {
+			sumDistance = sumDistance + s->dist[v];
+			if (kth >= 0 &&
+			    closenessBound(s, sumDistance, minWeight, limit, nV) < kth) {
+				pruned = true;
+				break;
+			}
+		}
+		tkv.numSettled += s->numSettled;
+
+		if (!pruned) {
+			double value = 0;
+			if (sumDistance != 0) {
+				value = calCloseness(sumDistance, s->numSettled, nV);
+			}
+			topKOffer(&tkv, k, src, value);
+		}
+	}
+	SSSPFree(s);
+	free(sources);
+	free(maxReach);
+	freeComponents(scc);
+
+	// turn the heap into a list, most central first
+	Ranked *result = malloc((tkv.k > 0 ? tkv.k : 1) * sizeof(Ranked));
+	if (result == NULL) {
+		fprintf(stderr, "Couldn't allocate top k arrays!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < tkv.k; i++) {
+		result[i] = (Ranked) {tkv.vertices[i], tkv.values[i]};
+	}
+	qsort(result, tkv.k, sizeof(Ranked), rankedCompare);
+	for (int i = 0; i < tkv.k; i++) {
+		tkv.vertices[i] = result[i].v;
+		tkv.values[i] = result[i].value;
+	}
+	free(result);
+	return tkv;
+}
+
+void freeTopKValues(TopKValues tkv) {
+	free(tkv.vertices);
+	free(tkv.values);
+}
+
+// O(sum over components of n * (n^2 + E)) for components of fewer than
+// BETWEENNESS_SPLIT nodes, dominated by the n calls to dijkstra, and
+// O(n * (n + E) log n) for larger ones, where n is the size of each weakly
+// connected component
 // This function calulates the betweenes of centrality
 // it is similar to the closeness but uses a method
 // of a path through the graph with a source, middle and destination node
 
 // Betweeness is the measurement of how many times the middle is a bridge along a 
 // path between different src, and dest nodes
+// No shortest path leaves the weakly connected component it starts in, so
+// each small component is worked out on its own copy of the graph, and
+// the components are shared out between threads. A large component's
+// sources are split into blocks that run in parallel as well, so one
+// giant component doesn't leave the other threads idle
 NodeValues betweennessCentrality(Graph g) {
 	if(g == NULL) {
 		fprintf(stderr, "Invalid graph\n");
 	}
 
 	int nV = GraphNumVertices(g);
-	NodeValues nvs = createNodeValues(nV);
-	
-	// Looping through g
-	// middle node
-	for(int middleN = 0; middleN < nV; middleN++) {
-		// source node
-		for(int srcN = 0; srcN < nV; srcN++) {
-			ShortestPaths sps = dijkstra(g, srcN);
-			
-			// destination node
-			for(int destN = 0; destN < nV; destN++) {
-				Path p;
-				p.src = srcN;
-				p.middle = middleN;
-				p.dest = destN;
-				
-				if(pathCheck(p)) {
-					nvs.values[middleN] = nvs.values[middleN] + calBetweeness(sps, p);
-				}
-				
-			}
-			freeShortestPaths(sps);
+	BetweennessJob job;
+	job.g = g;
+	job.wcc = weaklyConnectedComponents(g);
+	job.nvs = createNodeValues(nV);
+	job.cg = NULL;
+	int numThreads = SchedulerNumThreads();
+	job.sssp = calloc(numThreads, sizeof(SSSP));
+	job.delta = calloc(numThreads, sizeof(double *));
+	if (job.sssp == NULL || job.delta == NULL) {
+		fprintf(stderr, "Couldn't allocate workspaces!\n");
+		exit(EXIT_FAILURE);
+	}
+#ifndef CENTRALITY_EXACT_PATHS
+	// taken up front, as the components are worked on in parallel
+	for (int i = 0; i < job.wcc.numComponents; i++) {
+		if (componentSize(job.wcc, i) >= BETWEENNESS_SPLIT) {
+			job.cg = CompactGraphNew(g);
+			break;
 		}
 	}
-	return nvs;
+#endif
+
+	SchedulerFor(job.wcc.numComponents, 1, betweennessComponents, &job);
+
+	for (int t = 0; t < numThreads; t++) {
+		if (job.sssp[t] != NULL) {
+			SSSPFree(job.sssp[t]);
+		}
+		free(job.delta[t]);
+	}
+	free(job.sssp);
+	free(job.delta);
+	if (job.cg != NULL) {
+		CompactGraphFree(job.cg);
+	}
+	freeComponents(job.wcc);
+	return job.nvs;
 }
 
 // Same as betweennessCentrality, but normalises the value of the betweeness
@@ -131,6 +394,260 @@ NodeValues betweennessCentralityNormalised(Graph g) {
 	return nvs;
 }
 
+ApproxNodeValues betweennessCentralityApprox(Graph g, double epsilon,
+                                             double delta) {
+	return betweennessCentralityApproxSeeded(g, epsilon, delta,
+	                                         APPROX_DEFAULT_SEED, 0);
+}
+
+// O(r * (V + E) log V) where r = O((log V + log(1 / delta)) / epsilon^2)
+// Each sample picks a random ordered pair (u, v), runs dijkstra from u
+// until v is settled, then picks one of the shortest u -> v paths
+// uniformly at random and credits every vertex strictly inside it.
+// The fraction of samples that pass through w estimates
+// betweenness(w) / (nV * (nV - 1)), which is scaled back at the end.
+ApproxNodeValues betweennessCentralityApproxSeeded(Graph g, double epsilon,
+                                                   double delta,
+                                                   unsigned long seed,
+                                                   double timeBudget) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	assert(epsilon > 0 && epsilon < 1);
+	assert(delta > 0 && delta < 1);
+
+	int nV = GraphNumVertices(g);
+	ApproxNodeValues anv;
+	anv.nvs = createNodeValues(nV);
+	anv.numSamples = 0;
+	anv.epsilon = 0;
+	anv.delta = delta;
+	anv.halfWidth = 0;
+	// with fewer than 3 vertices no path has an inside, so 0 is exact
+	if (nV < 3) {
+		return anv;
+	}
+
+	double bound = sampleBound(nV, delta);
+	int required = (int)ceil(RK_CONSTANT * bound / (epsilon * epsilon));
+	double start = wallTime();
+	uint64_t state = seed;
+	SSSP s = SSSPNew(nV);
+
+	int numSamples = 0;
+	while (numSamples < required) {
+		if (timeBudget > 0 && wallTime() - start >= timeBudget) {
+			break;
+		}
+		Vertex u = nextRandom(&state) % nV;
+		Vertex v = nextRandom(&state) % (nV - 1);
+		if (v >= u) {
+			v++;
+		}
+		SSSPRun(s, g, u, v);
+		if (s->dist[v] != INFINITY) {
+			samplePath(s, g, v, anv.nvs.values, &state);
+		}
+		numSamples++;
+	}
+	SSSPFree(s);
+
+	double numPairs = (double)nV * (nV - 1);
+	anv.numSamples = numSamples;
+	if (numSamples == 0) {
+		// nothing was sampled, so only the trivial bound holds
+		anv.epsilon = 1;
+	} else {
+		for (Vertex v = 0; v < nV; v++) {
+			anv.nvs.values[v] = anv.nvs.values[v] * numPairs / numSamples;
+		}
+		anv.epsilon = sqrt(RK_CONSTANT * bound / numSamples);
+	}
+	anv.halfWidth = anv.epsilon * numPairs;
+	return anv;
+}
+
+// O(V * (V + E) log V), split across all cores
+// One shortest path search (with path counts) per src feeds every
+// requested measure: the distances give the closeness and harmonic sums,
+// and the dependency pass over the same search gives betweenness
+// The fused searches count paths in doubles, so with
+// CENTRALITY_EXACT_PATHS betweenness comes from betweennessCentrality
+// instead, which counts them exactly
+Centralities computeCentralities(Graph g, int flags) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	int nV = GraphNumVertices(g);
+	Centralities c;
+	c.closeness = (NodeValues) {0, NULL};
+	c.harmonic = (NodeValues) {0, NULL};
+	c.betweenness = (NodeValues) {0, NULL};
+	c.betweennessNormalised = (NodeValues) {0, NULL};
+
+	bool wantsBetweenness = (flags & (CENTRALITY_BETWEENNESS |
+	                                  CENTRALITY_BETWEENNESS_NORMALISED)) != 0;
+	bool wantsReach = (flags & (CENTRALITY_CLOSENESS |
+	                            CENTRALITY_HARMONIC)) != 0;
+	Reach *reach = NULL;
+	double *betweenness = NULL;
+#ifdef CENTRALITY_EXACT_PATHS
+	bool fused = false;
+#else
+	bool fused = wantsBetweenness;
+#endif
+
+	if (fused) {
+		FusedJob job;
+		job.cg = CompactGraphNew(g);
+		int numThreads = SchedulerNumThreads();
+		job.reach = malloc(nV * sizeof(Reach));
+		job.sssp = calloc(numThreads, sizeof(SSSP));
+		job.partial = calloc(numThreads, sizeof(double *));
+		job.delta = calloc(numThreads, sizeof(double *));
+		betweenness = calloc(nV, sizeof(double));
+		if (job.reach == NULL || job.sssp == NULL || job.partial == NULL ||
+		    job.delta == NULL || betweenness == NULL) {
+			fprintf(stderr, "Couldn't allocate centrality arrays!\n");
+			exit(EXIT_FAILURE);
+		}
+		SchedulerFor(nV, REACH_CHUNK, fusedSources, &job);
+
+		// summed in worker order
+		for (int t = 0; t < numThreads; t++) {
+			if (job.partial[t] == NULL) {
+				continue;
+			}
+			for (Vertex v = 0; v < nV; v++) {
+				betweenness[v] = betweenness[v] + job.partial[t][v];
+			}
+			SSSPFree(job.sssp[t]);
+			free(job.partial[t]);
+			free(job.delta[t]);
+		}
+		free(job.sssp);
+		free(job.partial);
+		free(job.delta);
+		CompactGraphFree(job.cg);
+		reach = job.reach;
+	} else if (wantsReach) {
+		reach = reachAll(g);
+	}
+	if (wantsBetweenness && !fused) {
+		betweenness = betweennessCentrality(g).values;
+	}
+
+	if (flags & CENTRALITY_CLOSENESS) {
+		c.closeness = createNodeValues(nV);
+		for (Vertex v = 0; v < nV; v++) {
+			if (reach[v].sumDistance != 0) {
+				c.closeness.values[v] = calCloseness(reach[v].sumDistance,
+				                                     reach[v].numVisited, nV);
+			}
+		}
+	}
+	if (flags & CENTRALITY_HARMONIC) {
+		c.harmonic = createNodeValues(nV);
+		for (Vertex v = 0; v < nV; v++) {
+			c.harmonic.values[v] = reach[v].harmonic;
+		}
+	}
+	if (flags & CENTRALITY_BETWEENNESS_NORMALISED) {
+		c.betweennessNormalised = createNodeValues(nV);
+		// nV can't be less than 3, as the normalisation becomes undefined
+		if (nV > 2) {
+			double normalise = 1 / (((double)nV - 1) * ((double)nV - 2));
+			for (Vertex v = 0; v < nV; v++) {
+				c.betweennessNormalised.values[v] = normalise * betweenness[v];
+			}
+		}
+	}
+	if (flags & CENTRALITY_BETWEENNESS) {
+		// hand the summed array straight over rather than copying it
+		c.betweenness = (NodeValues) {nV, betweenness};
+	} else {
+		free(betweenness);
+	}
+	free(reach);
+	return c;
+}
+
+void freeCentralities(Centralities c) {
+	free(c.closeness.values);
+	free(c.harmonic.values);
+	free(c.betweenness.values);
+	free(c.betweennessNormalised.values);
+}
+
+MemoryUsage nodeValuesMemoryUsage(NodeValues nvs) {
+	MemoryUsage m = {0};
+	if (nvs.values != NULL) {
+		MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nvs.numNodes * sizeof(double));
+	}
+	return m;
+}
+
+// O(V + E)
+// computeCentralities peaks either while the searches run, holding the
+// snapshot and every worker's workspace, or just after, once those are
+// freed and the results are made from the Reach array
+// With CENTRALITY_EXACT_PATHS, betweenness is left to
+// betweennessCentrality, whose dijkstra calls aren't counted here
+MemoryUsage computeCentralitiesMemoryEstimate(Graph g, int flags) {
+	int nV = GraphNumVertices(g);
+	int numThreads = SchedulerNumThreads();
+	bool wantsBetweenness = (flags & (CENTRALITY_BETWEENNESS |
+	                                  CENTRALITY_BETWEENNESS_NORMALISED)) != 0;
+	bool wantsReach = (flags & (CENTRALITY_CLOSENESS |
+	                            CENTRALITY_HARMONIC)) != 0;
+#ifdef CENTRALITY_EXACT_PATHS
+	bool fused = false;
+#else
+	bool fused = wantsBetweenness;
+#endif
+	MemoryUsage searching = {0};
+	MemoryUsage results = {0};
+	if (!wantsBetweenness && !wantsReach) {
+		return searching;
+	}
+
+	MemoryAdd(&searching, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(Reach));
+	MemoryCombine(&searching, CompactGraphMemoryEstimate(g));
+	MemoryUsage worker = {0};
+	if (fused) {
+		MemoryAdd(&searching, MEMORY_HEADER, 3, numThreads * sizeof(void *));
+		MemoryAdd(&searching, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(double));
+		worker = SSSPMemoryEstimate(nV);
+		MemoryAdd(&worker, MEMORY_WORKSPACE, 2, nV * sizeof(double));
+	} else {
+		MemoryAdd(&searching, MEMORY_HEADER, 1, numThreads * sizeof(SSSP));
+		MemoryAdd(&searching, MEMORY_HEADER, 1,
+		          numThreads * sizeof(BFSWorkspace));
+		if (uniformWeight(g) != 0) {
+			// the weakly connected components, with at most nV of them
+			MemoryAdd(&searching, MEMORY_VERTEX_ARRAYS, 3, nV * sizeof(int));
+			MemoryAdd(&searching, MEMORY_VERTEX_ARRAYS, 1,
+			          (nV + 1) * sizeof(int));
+			MemoryAdd(&worker, MEMORY_WORKSPACE, 3, nV * sizeof(uint64_t));
+			MemoryAdd(&worker, MEMORY_WORKSPACE, 2, nV * sizeof(Vertex));
+		} else {
+			worker = SSSPMemoryEstimate(nV);
+		}
+	}
+	for (int t = 0; t < numThreads; t++) {
+		MemoryCombine(&searching, worker);
+	}
+
+	MemoryAdd(&results, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(Reach));
+	for (int flag = CENTRALITY_CLOSENESS; flag <= CENTRALITY_ALL; flag <<= 1) {
+		if ((flags & flag) || (flag == CENTRALITY_BETWEENNESS &&
+		                       wantsBetweenness)) {
+			MemoryAdd(&results, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(double));
+		}
+	}
+	return searching.total > results.total ? searching : results;
+}
+
 void showNodeValues(NodeValues nvs) {
 	printf("nV : %d\n", nvs.numNodes);
 	printf("=== Node Values ===\n");
@@ -143,23 +660,21 @@ void freeNodeValues(NodeValues nvs) {
 	free(nvs.values);
 }
 
-// ========================
-// === HELPER FUNCTIONS ===
-// ========================
-
-// helper that creates a NodeValues array
-static NodeValues createNodeValues(int numNodes) {
+NodeValues createNodeValues(int numNodes) {
 	NodeValues new;
 	new.numNodes = numNodes;
-	new.values = calloc(numNodes, sizeof(double));
+	new.values = calloc(numNodes > 0 ? numNodes : 1, sizeof(double));
+	if (new.values == NULL) {
+		fprintf(stderr, "Couldn't allocate NodeValues!\n");
+		exit(EXIT_FAILURE);
+	}
 	return new;
 }
 
-
 // calulates closeness using the Wasserman and Faust formula
 // this function assumes that the node is connected and not isolated
-static double calCloseness(double distanceSum, int numVisted, int nV) {
-	double numVist = (numVisted - 1) * (numVisted - 1);
+double calCloseness(double distanceSum, int numVisted, int nV) {
+	double numVist = (double)(numVisted - 1) * (numVisted - 1);
 	double nnV = nV - 1;
 	double sum = 1 / distanceSum;
 	
@@ -168,62 +683,657 @@ static double calCloseness(double distanceSum, int numVisted, int nV) {
 	return value;
 }
 
-// checks to see if the path could be a valid path
-// i.e src != dest, src != middle, middle != dest
-static bool pathCheck(Path p) {
-	bool first = (p.src != p.middle);
-	bool second = (p.src != p.dest);
-	bool third = (p.middle != p.dest);
-	return (first && second && third);
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// counts the shortest paths from sps.src to every node it reaches, each
+// one exactly once: sorting the reached nodes by distance puts every
+// predecessor before the nodes it leads to, so each count is just the sum
+// of its predecessors' already final counts
+// fills order with the reached nodes (src first) and returns how many
+// O(V log V + number of predecessors)
+static int countPaths(ShortestPaths sps, Settled *order, PathCount *numPaths) {
+	int numReached = 0;
+	for(Vertex v = 0; v < sps.numNodes; v++) {
+		if(sps.dist[v] != INFINITY) {
+			order[numReached++] = (Settled) {v, sps.dist[v]};
+		}
+	}
+	qsort(order, numReached, sizeof(Settled), settledCompare);
+
+	numPaths[sps.src] = 1;
+	for(int i = 1; i < numReached; i++) {
+		Vertex v = order[i].v;
+		PathCount count = 0;
+		for(PredNode *head = sps.pred[v]; head != NULL; head = head->next) {
+			count = addPaths(count, numPaths[head->v]);
+			STATS_ADD(STATS_PATH_STEPS, 1);
+		}
+		numPaths[v] = count;
+	}
+	return numReached;
+}
+
+// adds two path counts, refusing to silently wrap around
+static PathCount addPaths(PathCount x, PathCount y) {
+	PathCount sum;
+#ifdef CENTRALITY_EXACT_PATHS
+	if(__builtin_add_overflow(x, y, &sum)) {
+		fprintf(stderr, "Shortest path count overflowed 128 bits\n");
+		exit(EXIT_FAILURE);
+	}
+#else
+	sum = x + y;
+	if(isinf(sum)) {
+		fprintf(stderr, "Shortest path count overflowed a double\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	return sum;
+}
+
+// qsort comparator putting the closest Settled first
+static int settledCompare(const void *a, const void *b) {
+	const Settled *s1 = a;
+	const Settled *s2 = b;
+	return (s1->dist > s2->dist) - (s1->dist < s2->dist);
+}
+
+// the bracketed term of the Riondato & Kornaropoulos sample size
+// floor(log2(VD - 2)) + 1 + ln(1 / delta), where VD is the vertex
+// diameter. nV is used as the bound on VD as computing the real
+// diameter of a directed graph costs as much as the exact measure
+static double sampleBound(int nV, double delta) {
+	double vd = nV;
+	return floor(log2(vd - 2)) + 1 + log(1 / delta);
+}
+
+// walks backwards from dest to the source of the last SSSPRun, choosing
+// each predecessor with probability proportional to its path count, so
+// every shortest path is equally likely
+// O(length of path * in-degree)
+static void samplePath(SSSP s, Graph g, Vertex dest, double *values,
+                       uint64_t *state) {
+	Vertex curr = dest;
+	while (curr != s->src) {
+		double pick = (nextRandom(state) >> 11) * 0x1.0p-53 * s->sigma[curr];
+		Vertex chosen = -1;
+		for (AdjList in = GraphInIncident(g, curr); in != NULL; in = in->next) {
+			Vertex z = in->v;
+			// only predecessors on a shortest path, which are all settled
+			if (s->dist[z] != INFINITY &&
+			    s->dist[z] + in->weight == s->dist[curr]) {
+				chosen = z;
+				pick = pick - s->sigma[z];
+				if (pick < 0) {
+					break;
+				}
+			}
+		}
+		assert(chosen != -1);
+		if (chosen != s->src) {
+			values[chosen] = values[chosen] + 1;
+		}
+		curr = chosen;
+	}
+}
+
+// splitmix64, small and fast with a full 64 bit output
+static uint64_t nextRandom(uint64_t *state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// seconds since some fixed point, for the time budget
+static double wallTime(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// the highest closeness the src of a search that has settled some nodes
+// can still end up with
+// every queued node is at least SSSPFrontierDist away, and every node not
+// reached yet is at least minWeight further, since it can only be reached
+// through a node that hasn't been settled. The final number of reached
+// nodes is somewhere between what has been reached so far and maxReach, and
+// closeness is highest at one of the two ends of that range, so checking
+// both gives an upper bound
+// O(1)
+static double closenessBound(SSSP s, double sumDistance, int minWeight,
+                             int maxReach, int nV) {
+	int numQueued = SSSPNumQueued(s);
+	if (numQueued == 0) {
+		return sumDistance == 0 ? 0 :
+		       calCloseness(sumDistance, s->numSettled, nV);
+	}
+	int frontierDist = SSSPFrontierDist(s);
+	double queuedSum = sumDistance + (double)numQueued * frontierDist;
+	int reached = s->numSettled + numQueued;
+	double low = boundAt(reached, reached, queuedSum, 0, nV);
+	double high = boundAt(maxReach, reached, queuedSum,
+	                      (double)frontierDist + minWeight, nV);
+	return low > high ? low : high;
 }
 
-// helper function that calulates the betweeness of the graph
-static double calBetweeness(ShortestPaths sps, Path p) {
-	double numberPaths = numPaths(sps, p);
-	// isolated node
-	if (numberPaths == 0) {
+// closeness if 'total' nodes end up reached, where the ones beyond the
+// first 'reached' are each at least 'nextDist' away
+static double boundAt(int total, int reached, double sumDistance,
+                      double nextDist, int nV) {
+	double bestSum = sumDistance + (total - reached) * nextDist;
+	if (bestSum == 0) {
 		return 0;
 	}
+	return calCloseness(bestSum, total, nV);
+}
 
-	double numThrough = numPathFinder(sps, p);
+// adds v to the top k if it beats the worst one there
+// the top k is kept as a heap with the worst node at index 0
+// O(log k)
+static void topKOffer(TopKValues *tkv, int k, Vertex v, double value) {
+	int i;
+	if (tkv->k < k) {
+		// sift the new node up from the bottom
+		i = tkv->k++;
+		while (i > 0) {
+			int parent = (i - 1) / 2;
+			if (!rankedWorse(v, value, tkv->vertices[parent],
+			                 tkv->values[parent])) {
+				break;
+			}
+			tkv->vertices[i] = tkv->vertices[parent];
+			tkv->values[i] = tkv->values[parent];
+			i = parent;
+		}
+	} else if (rankedWorse(tkv->vertices[0], tkv->values[0], v, value)) {
+		// replace the worst node and sift down
+		i = 0;
+		for (;;) {
+			int child = 2 * i + 1;
+			if (child >= tkv->k) {
+				break;
+			}
+			if (child + 1 < tkv->k &&
+			    rankedWorse(tkv->vertices[child + 1], tkv->values[child + 1],
+			                tkv->vertices[child], tkv->values[child])) {
+				child++;
+			}
+			if (!rankedWorse(tkv->vertices[child], tkv->values[child],
+			                 v, value)) {
+				break;
+			}
+			tkv->vertices[i] = tkv->vertices[child];
+			tkv->values[i] = tkv->values[child];
+			i = child;
+		}
+	} else {
+		return;
+	}
+	tkv->vertices[i] = v;
+	tkv->values[i] = value;
+}
 
-	double calulated = numThrough / numberPaths;
-	return calulated;
+// lower values are worse, and on a tie the higher node number is worse
+static bool rankedWorse(Vertex v1, double value1, Vertex v2, double value2) {
+	return value1 < value2 || (value1 == value2 && v1 > v2);
 }
 
-// calulcates number of paths p.src to p.dest 
-static int numPaths(ShortestPaths sps, Path p) {
-	int numP = 0;
-	PredNode *head = sps.pred[p.dest];
-	if(p.src == p.dest) {
+// qsort comparator putting the best Ranked first
+static int rankedCompare(const void *a, const void *b) {
+	const Ranked *r1 = a;
+	const Ranked *r2 = b;
+	if (rankedWorse(r1->v, r1->value, r2->v, r2->value)) {
 		return 1;
+	} else if (rankedWorse(r2->v, r2->value, r1->v, r1->value)) {
+		return -1;
+	}
+	return 0;
+}
+
+// runs one shortest path search per node, sharing the nodes out between
+// threads, and returns what each node reaches
+// O(V * (V + E) log V), or O(V * E / 64) if the graph is unweighted
+static Reach *reachAll(Graph g) {
+	int nV = GraphNumVertices(g);
+	ReachJob job;
+	job.cg = CompactGraphNew(g);
+	job.unitWeight = job.cg->weightBytes == 0 ? job.cg->weight : 0;
+	job.reach = malloc(nV * sizeof(Reach));
+	if (job.reach == NULL) {
+		fprintf(stderr, "Couldn't allocate reach array!\n");
+		exit(EXIT_FAILURE);
+	}
+	int numThreads = SchedulerNumThreads();
+	job.sssp = calloc(numThreads, sizeof(SSSP));
+	job.bfs = calloc(numThreads, sizeof(BFSWorkspace));
+	if (job.sssp == NULL || job.bfs == NULL) {
+		fprintf(stderr, "Couldn't allocate workspaces!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (job.unitWeight != 0) {
+		job.wcc = weaklyConnectedComponents(g);
+		SchedulerFor((nV + BFS_BATCH - 1) / BFS_BATCH, 1, reachBatches, &job);
+		freeComponents(job.wcc);
 	} else {
-		// calculating
-		while(head != NULL) {
-			Path s = p;
-			s.dest = head->v;
-			numP = numP + numPaths(sps, s);
-			head = head->next;
+		SchedulerFor(nV, REACH_CHUNK, reachSources, &job);
+	}
+
+	for (int t = 0; t < numThreads; t++) {
+		if (job.sssp[t] != NULL) {
+			SSSPFree(job.sssp[t]);
 		}
+		free(job.bfs[t].visited);
+		free(job.bfs[t].frontier);
+		free(job.bfs[t].next);
+		free(job.bfs[t].curr);
+		free(job.bfs[t].found);
 	}
-	return numP;
+	free(job.sssp);
+	free(job.bfs);
+	CompactGraphFree(job.cg);
+	return job.reach;
 }
 
-// counting how many times p.middle appears
-static int numPathFinder(ShortestPaths sps, Path p) {
-	int count = 0;
+// runs a shortest path search from each of the sources lo to hi - 1
+// each source's Reach is written by exactly one thread, so the results
+// don't depend on how the work was split up
+static void reachSources(void *arg, int lo, int hi) {
+	ReachJob *job = arg;
+	int nV = job->cg->numNodes;
+	int id = SchedulerWorkerId();
+	if (job->sssp[id] == NULL) {
+		job->sssp[id] = SSSPNew(nV);
+	}
+	SSSP s = job->sssp[id];
 
-	if(p.middle != p.dest) {
-		PredNode *head = sps.pred[p.dest];
-		while(head != NULL) {
-			Path s = p;
-			s.dest = head->v;
-			count = count + numPathFinder(sps, s);
-			head = head->next;
+	for (Vertex src = lo; src < hi; src++) {
+		SSSPRunDistancesCompact(s, job->cg, src);
+		Reach r = {s->numSettled, 0, 0};
+		// order[0] is the src itself
+		for (int i = 1; i < s->numSettled; i++) {
+			int d = s->dist[s->order[i]];
+			r.sumDistance = r.sumDistance + d;
+			r.harmonic = r.harmonic + 1.0 / d;
 		}
-	} else {
-		count = numPaths(sps, p);
+		job->reach[src] = r;
+	}
+}
+
+// runs the bit parallel BFS for batches lo to hi - 1 of BFS_BATCH sources,
+// taken in the order of wcc.members so each batch only spans the
+// components it needs to
+static void reachBatches(void *arg, int lo, int hi) {
+	ReachJob *job = arg;
+	int nV = job->cg->numNodes;
+	BFSWorkspace *w = &job->bfs[SchedulerWorkerId()];
+	if (w->visited == NULL) {
+		w->visited = malloc(nV * sizeof(uint64_t));
+		w->frontier = calloc(nV, sizeof(uint64_t));
+		w->next = calloc(nV, sizeof(uint64_t));
+		w->curr = malloc(nV * sizeof(Vertex));
+		w->found = malloc(nV * sizeof(Vertex));
+		if (w->visited == NULL || w->frontier == NULL || w->next == NULL ||
+		    w->curr == NULL || w->found == NULL) {
+			fprintf(stderr, "Couldn't allocate BFS workspace!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (int batch = lo; batch < hi; batch++) {
+		int first = batch * BFS_BATCH;
+		int count = nV - first < BFS_BATCH ? nV - first : BFS_BATCH;
+		COMPACT_DISPATCH(job->cg, reachBFSBatch, job,
+		                 &job->wcc.members[first], count, w);
 	}
+}
+
+// runs a shortest path search from each of the sources lo to hi - 1,
+// recording its Reach and adding its dependencies to this worker's own
+// betweenness sums
+static void fusedSources(void *arg, int lo, int hi) {
+	FusedJob *job = arg;
+	int nV = job->cg->numNodes;
+	int id = SchedulerWorkerId();
+	if (job->sssp[id] == NULL) {
+		job->sssp[id] = SSSPNew(nV);
+		job->partial[id] = calloc(nV, sizeof(double));
+		job->delta[id] = malloc(nV * sizeof(double));
+		if (job->partial[id] == NULL || job->delta[id] == NULL) {
+			fprintf(stderr, "Couldn't allocate centrality arrays!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	SSSP s = job->sssp[id];
+	double *betweenness = job->partial[id];
+	double *delta = job->delta[id];
+
+	for (Vertex src = lo; src < hi; src++) {
+		SSSPRunCompact(s, job->cg, src);
+		SSSPAccumulateCompact(s, job->cg, delta);
+		Reach r = {s->numSettled, 0, 0};
+		// order[0] is the src itself
+		for (int i = 1; i < s->numSettled; i++) {
+			Vertex w = s->order[i];
+			int d = s->dist[w];
+			r.sumDistance = r.sumDistance + d;
+			r.harmonic = r.harmonic + 1.0 / d;
+			betweenness[w] = betweenness[w] + delta[w];
+		}
+		job->reach[src] = r;
+	}
+}
 
-	return count;
-}
\ No newline at end of file
+// works out the betweenness of the nodes in components lo to hi - 1
+// a component of one or two nodes has no middle nodes, a large one has
+// its sources split up, and one that is the whole graph doesn't need
+// copying
+static void betweennessComponents(void *arg, int lo, int hi) {
+	BetweennessJob *job = arg;
+	Components wcc = job->wcc;
+	for (int i = lo; i < hi; i++) {
+		int size = componentSize(wcc, i);
+		if (size < 3) {
+			continue;
+		}
+		if (job->cg != NULL && size >= BETWEENNESS_SPLIT) {
+			splitBetweenness(job, i);
+			continue;
+		}
+		if (size == wcc.numNodes) {
+			componentBetweenness(job->g, job->nvs.values);
+			continue;
+		}
+		Graph sub = componentSubgraph(job->g, wcc, i);
+		double *values = calloc(size, sizeof(double));
+		if (values == NULL) {
+			fprintf(stderr, "Couldn't allocate centrality arrays!\n");
+			exit(EXIT_FAILURE);
+		}
+		componentBetweenness(sub, values);
+		for (int j = 0; j < size; j++) {
+			job->nvs.values[wcc.members[wcc.start[i] + j]] = values[j];
+		}
+		free(values);
+		GraphFree(sub);
+	}
+}
+
+// adds the betweenness of every node in g to values
+// Each src only needs one dijkstra: the number of shortest paths to every
+// node is counted once over the predecessor DAG (countPaths), and then the
+// share of paths through each middle node is pushed back from the furthest
+// dest to the src (Brandes' dependency accumulation)
+// O(V * (V^2 + E))
+static void componentBetweenness(Graph g, double *values) {
+	int nV = GraphNumVertices(g);
+	PathCount *numPaths = malloc(nV * sizeof(PathCount));
+	double *dependency = malloc(nV * sizeof(double));
+	Settled *order = malloc(nV * sizeof(Settled));
+	if (numPaths == NULL || dependency == NULL || order == NULL) {
+		fprintf(stderr, "Couldn't allocate path counts!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// source node
+	for(int srcN = 0; srcN < nV; srcN++) {
+		ShortestPaths sps = dijkstra(g, srcN);
+		STATS_TIMER(start);
+		int numReached = countPaths(sps, order, numPaths);
+		STATS_TIMER_STOP(start, STATS_PATH_COUNTING);
+
+		// order[0] is the src, the only node with no predecessors
+		for(int i = 0; i < numReached; i++) {
+			dependency[order[i].v] = 0;
+		}
+		for(int i = numReached - 1; i > 0; i--) {
+			Vertex destN = order[i].v;
+			double share = (1 + dependency[destN]) / (double)numPaths[destN];
+			for(PredNode *head = sps.pred[destN]; head != NULL; head = head->next) {
+				dependency[head->v] += (double)numPaths[head->v] * share;
+			}
+			// middle node
+			values[destN] = values[destN] + dependency[destN];
+		}
+		freeShortestPaths(sps);
+	}
+	free(numPaths);
+	free(dependency);
+	free(order);
+}
+
+// works out the betweenness of the nodes in large component i, with its
+// sources split into BETWEENNESS_BLOCKS blocks that run in parallel
+// the searches run over the snapshot of the whole graph, which they can't
+// leave the component in, and each block adds its sources' dependencies
+// up in its own partial sums, indexed by rank in the component
+// the blocks don't depend on the number of threads, and SchedulerReduce
+// adds them up in order, so neither does the result
+// O(n * (n + E) log n), where n is the size of the component
+static void splitBetweenness(BetweennessJob *job, int i) {
+	Components wcc = job->wcc;
+	int size = componentSize(wcc, i);
+	double *values = malloc(size * sizeof(double));
+	if (values == NULL) {
+		fprintf(stderr, "Couldn't allocate centrality arrays!\n");
+		exit(EXIT_FAILURE);
+	}
+	ComponentSources sources = {job, i};
+	int grain = (size + BETWEENNESS_BLOCKS - 1) / BETWEENNESS_BLOCKS;
+	SchedulerReduce(size, grain, size, values, betweennessSources, &sources);
+	for (int j = 0; j < size; j++) {
+		job->nvs.values[wcc.members[wcc.start[i] + j]] = values[j];
+	}
+	free(values);
+}
+
+// searches from the sources lo to hi - 1 of a large component, in the
+// order of wcc.members, adding their dependencies into partial
+static void betweennessSources(void *arg, int lo, int hi, double *partial) {
+	ComponentSources *sources = arg;
+	BetweennessJob *job = sources->job;
+	Components wcc = job->wcc;
+	int id = SchedulerWorkerId();
+	if (job->sssp[id] == NULL) {
+		job->sssp[id] = SSSPNew(wcc.numNodes);
+		job->delta[id] = malloc(wcc.numNodes * sizeof(double));
+		if (job->delta[id] == NULL) {
+			fprintf(stderr, "Couldn't allocate centrality arrays!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	SSSP s = job->sssp[id];
+	double *delta = job->delta[id];
+
+	const Vertex *members = &wcc.members[wcc.start[sources->component]];
+	for (int j = lo; j < hi; j++) {
+		SSSPRunCompact(s, job->cg, members[j]);
+		SSSPAccumulateCompact(s, job->cg, delta);
+		// order[0] is the src itself
+		for (int k = 1; k < s->numSettled; k++) {
+			Vertex w = s->order[k];
+			partial[wcc.rank[w]] = partial[wcc.rank[w]] + delta[w];
+		}
+	}
+}
+
+// breadth first search from up to 64 sources at once, where bit b of
+// each mask belongs to sources[b], so one pass over an edge moves every
+// search along it
+// only nodes whose mask changed in the last level are expanded, and a
+// node can only change on 64 different levels, so this is O(64 * E)
+// in the worst case and usually much less
+// the sources are consecutive in wcc.members, so the searches can only
+// visit the components from the first source's to the last one's, and
+// only those nodes need clearing
+// compiled once for each vertex width by COMPACT_DISPATCH (the weights
+// are all job->unitWeight, so weightBytes is always 0)
+static inline __attribute__((always_inline))
+void reachBFSBatch(ReachJob *job, const Vertex *sources, int count,
+                   BFSWorkspace *w, int vertexBytes, int weightBytes) {
+	uint64_t *visited = w->visited;
+	uint64_t *frontier = w->frontier;
+	uint64_t *next = w->next;
+	Vertex *curr = w->curr;
+	Vertex *found = w->found;
+	(void)weightBytes;
+	const int *start = job->cg->outStart;
+	const void *outTo = job->cg->outTo;
+	Components wcc = job->wcc;
+	int lastMember = wcc.start[wcc.component[sources[count - 1]] + 1];
+	for (int j = wcc.start[wcc.component[sources[0]]]; j < lastMember; j++) {
+		visited[wcc.members[j]] = 0;
+	}
+
+	int numCurr = 0;
+	for (int b = 0; b < count; b++) {
+		uint64_t bit = (uint64_t)1 << b;
+		visited[sources[b]] = bit;
+		frontier[sources[b]] = bit;
+		curr[numCurr++] = sources[b];
+		job->reach[sources[b]] = (Reach) {1, 0, 0};
+	}
+
+	for (int level = 1; numCurr > 0; level++) {
+		int numFound = 0;
+		for (int i = 0; i < numCurr; i++) {
+			Vertex u = curr[i];
+			for (int e = start[u]; e < start[u + 1]; e++) {
+				Vertex v = compactVertex(outTo, vertexBytes, e);
+				uint64_t fresh = frontier[u] & ~visited[v];
+				if (fresh != 0) {
+					if (next[v] == 0) {
+						found[numFound++] = v;
+					}
+					next[v] |= fresh;
+				}
+			}
+		}
+		for (int i = 0; i < numCurr; i++) {
+			frontier[curr[i]] = 0;
+		}
+
+		double d = (double)level * job->unitWeight;
+		for (int i = 0; i < numFound; i++) {
+			Vertex v = found[i];
+			uint64_t bits = next[v];
+			visited[v] |= bits;
+			frontier[v] = bits;
+			next[v] = 0;
+			while (bits != 0) {
+				Reach *r = &job->reach[sources[__builtin_ctzll(bits)]];
+				r->numVisited++;
+				r->sumDistance = r->sumDistance + d;
+				r->harmonic = r->harmonic + 1 / d;
+				bits &= bits - 1;
+			}
+		}
+
+		Vertex *tmp = curr;
+		curr = found;
+		found = tmp;
+		numCurr = numFound;
+	}
+}
+
+// returns the smallest edge weight, or 1 if there are no edges
+// O(V + E)
+static int minimumWeight(Graph g) {
+	int weight = INFINITY;
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+			if (out->weight < weight) {
+				weight = out->weight;
+			}
+		}
+	}
+	return weight == INFINITY ? 1 : weight;
+}
+
+// returns, for each strongly connected component, the most nodes a search
+// from inside it can reach: the total size of the components it can reach
+// in the condensation, itself included
+// every edge of the condensation goes to a lower numbered component, so
+// each component's set of descendants is itself joined with the sets of
+// the components it has edges to, kept as one bit per component
+// past REACH_EXACT_COMPONENTS components those sets would take too much
+// memory, and the limit is instead its own size plus the limits of the
+// components it has edges to, capped at nV; that is still never below
+// the real reach, but counts a component once for every path down to it
+// O(V + E log E + C^2), where C is the number of components
+static int *reachLimits(Graph g, Components scc) {
+	int nV = GraphNumVertices(g);
+	int numComponents = scc.numComponents;
+	Graph dag = condensationGraph(g, scc);
+	int *limit = malloc((numComponents > 0 ? numComponents : 1) *
+	                    sizeof(int));
+	if (limit == NULL) {
+		fprintf(stderr, "Couldn't allocate reach limits!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (numComponents > REACH_EXACT_COMPONENTS) {
+		for (int i = 0; i < numComponents; i++) {
+			long total = componentSize(scc, i);
+			for (AdjList out = GraphOutIncident(dag, i); out != NULL;
+			     out = out->next) {
+				total = total + limit[out->v];
+			}
+			limit[i] = total < nV ? total : nV;
+		}
+		GraphFree(dag);
+		return limit;
+	}
+
+	// component i's descendants only take the words up to bit i
+	int numWords = (numComponents + 63) / 64;
+	uint64_t *below = calloc((size_t)numComponents * numWords,
+	                         sizeof(uint64_t));
+	if (below == NULL) {
+		fprintf(stderr, "Couldn't allocate reach limits!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < numComponents; i++) {
+		uint64_t *row = &below[(size_t)i * numWords];
+		int lastWord = i / 64;
+		row[lastWord] = (uint64_t)1 << (i % 64);
+		for (AdjList out = GraphOutIncident(dag, i); out != NULL;
+		     out = out->next) {
+			const uint64_t *child = &below[(size_t)out->v * numWords];
+			for (int w = 0; w <= out->v / 64; w++) {
+				row[w] |= child[w];
+			}
+		}
+		int total = 0;
+		for (int w = 0; w <= lastWord; w++) {
+			for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+				total = total + componentSize(scc, 64 * w +
+				                              __builtin_ctzll(bits));
+			}
+		}
+		limit[i] = total;
+	}
+	free(below);
+	GraphFree(dag);
+	return limit;
+}
+
+// returns the weight shared by every edge, or 0 if the weights differ
+// O(V + E)
+static int uniformWeight(Graph g) {
+	int weight = -1;
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+			if (weight == -1) {
+				weight = out->weight;
+			} else if (out->weight != weight) {
+				return 0;
+			}
+		}
+	}
+	// with no edges every search stops at its src anyway
+	return weight == -1 ? 1 : weight;
+}
@@ -0,0 +1,145 @@
+// Centrality Measures API extensions
+// COMP2521 Assignment 2
+
+// Measures and variants added on top of CentralityMeasures.h, which is
+// fixed by the assignment and so left exactly as it was given.
+
+#ifndef CENTRALITY_MEASURES_EXT_H
+#define CENTRALITY_MEASURES_EXT_H
+
+#include <stdbool.h>
+
+#include "CentralityMeasures.h"
+#include "Graph.h"
+#include "MemoryUsage.h"
+
+// Flags for computeCentralities, combined with |
+#define CENTRALITY_CLOSENESS              (1 << 0)
+#define CENTRALITY_HARMONIC               (1 << 1)
+#define CENTRALITY_BETWEENNESS            (1 << 2)
+#define CENTRALITY_BETWEENNESS_NORMALISED (1 << 3)
+#define CENTRALITY_ALL                    ((1 << 4) - 1)
+
+typedef struct Centralities {
+	NodeValues closeness;             // Each measure that was not asked
+	NodeValues harmonic;              // for has numNodes 0 and values
+	NodeValues betweenness;           // NULL
+	NodeValues betweennessNormalised;
+} Centralities;
+
+typedef struct ApproxNodeValues {
+	NodeValues nvs;   // The estimates, in the same units as the exact
+	                  // function they approximate
+	int numSamples;   // The number of shortest paths that were sampled
+	double epsilon;   // The achieved error bound on the normalised
+	                  // values (value / (nV * (nV - 1)))
+	double delta;     // The probability that the bound does not hold
+	double halfWidth; // epsilon in the units of nvs: with probability
+	                  // at least 1 - delta, every estimate is within
+	                  // halfWidth of the exact value
+} ApproxNodeValues;
+
+typedef struct TopKValues {
+	int k;            // The number of vertices returned
+	Vertex *vertices; // The vertices, most central first
+	double *values;   // values[i] is the value of vertices[i]
+	long numSettled;  // The total number of vertices settled by all of
+	                  // the shortest path searches, a measure of the
+	                  // work done (a full computation settles up to nV^2)
+} TopKValues;
+
+/**
+ * Finds  the  harmonic  centrality  for each vertex in the given graph,
+ * the  sum  of  1 / distance  over  every vertex it can reach, and returns
+ * the  results  in a NodeValues structure. Unlike closeness, vertices it
+ * cannot reach simply contribute nothing.
+ */
+NodeValues harmonicCentrality(Graph g);
+
+/**
+ * Finds  both  the  closeness  and harmonic centrality for each vertex,
+ * running the shortest path searches only once for both.
+ */
+void closenessHarmonicCentrality(Graph g, NodeValues *closeness,
+                                 NodeValues *harmonic);
+
+/**
+ * Finds the k vertices with the highest closeness centrality (as given
+ * by  closenessCentrality)  without computing every value in full. Each
+ * search is abandoned as soon as an upper bound on its closeness falls
+ * below the current k-th best value (Bergamini et al.). Ties are broken
+ * in favour of the lower vertex number.
+ */
+TopKValues closenessTopK(Graph g, int k);
+
+/**
+ * Frees all memory associated with the given TopKValues structure.
+ */
+void freeTopKValues(TopKValues tkv);
+
+/**
+ * Estimates  the  betweenness  centrality  of every vertex by sampling
+ * shortest paths between uniformly random pairs of vertices (Riondato &
+ * Kornaropoulos).  Enough  paths  are  sampled  that, with probability
+ * at least 1 - delta, every normalised estimate is within epsilon of the
+ * exact  value.  The  estimates are scaled to the units returned by
+ * betweennessCentrality. The run is reproducible for a fixed seed.
+ */
+ApproxNodeValues betweennessCentralityApprox(Graph g, double epsilon,
+                                             double delta);
+
+/**
+ * Same as betweennessCentralityApprox, but with an explicit seed and an
+ * optional time budget in seconds (0 for no limit). If the budget runs
+ * out before enough paths have been sampled, the estimates from the
+ * paths sampled so far are returned and epsilon/halfWidth report the
+ * (larger) error bound those samples actually achieve.
+ */
+ApproxNodeValues betweennessCentralityApproxSeeded(Graph g, double epsilon,
+                                                   double delta,
+                                                   unsigned long seed,
+                                                   double timeBudget);
+
+/**
+ * Computes every measure selected by 'flags' (CENTRALITY_* above, or'd
+ * together) in a single pass that runs one shortest path search per
+ * vertex and feeds all of the measures from it. Each result equals what
+ * the matching function above returns, up to floating point rounding.
+ * Like them, it exits with an error if a shortest path count overflows.
+ * When compiled with -DCENTRALITY_EXACT_PATHS, the single pass only
+ * gives closeness and harmonic centrality, and betweenness is
+ * computed by betweennessCentrality, with its exact path counts.
+ */
+Centralities computeCentralities(Graph g, int flags);
+
+/**
+ * Frees all memory associated with the given Centralities structure.
+ */
+void freeCentralities(Centralities c);
+
+/**
+ * Returns a NodeValues structure for numNodes nodes, with every value 0.
+ */
+NodeValues createNodeValues(int numNodes);
+
+/**
+ * Returns the closeness (Wasserman and Faust) of a vertex that reaches
+ * numVisited vertices, itself included, at a total distance of
+ * distanceSum, in a graph of nV vertices. distanceSum must not be 0.
+ */
+double calCloseness(double distanceSum, int numVisited, int nV);
+
+/**
+ * Returns  the  memory  held  by  the  given  NodeValues structure.
+ */
+MemoryUsage nodeValuesMemoryUsage(NodeValues nvs);
+
+/**
+ * Returns  the  most memory  computeCentralities(g, flags) holds at once,
+ * including  the  results  it  returns,  when  every thread takes part.
+ * closenessCentrality and harmonicCentrality  hold  the same as with just
+ * their own flag.
+ */
+MemoryUsage computeCentralitiesMemoryEstimate(Graph g, int flags);
+
+#endif
@@ -0,0 +1,208 @@
+// Compressed read only snapshot of a graph implementation
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CompactGraph.h"
+#include "Graph.h"
+
+static void chooseWidths(Graph g, int *vertexBytes, int *weightBytes,
+                         int *weight);
+static MemoryUsage layoutMemoryUsage(int numNodes, size_t numEdges,
+                                     int vertexBytes, int weightBytes);
+static void *allocate(size_t count, size_t size);
+static int *fillStarts(Graph g, AdjList (*incident)(Graph, Vertex));
+static void fillEdges(CompactGraph cg, Graph g,
+                      AdjList (*incident)(Graph, Vertex), void *vertices,
+                      void *weights);
+static void setVertex(void *vertices, int vertexBytes, int e, Vertex v);
+static void setWeight(void *weights, int weightBytes, int e, int weight);
+
+// O(V + E)
+CompactGraph CompactGraphNew(Graph g) {
+	assert(g != NULL);
+
+	CompactGraph cg = malloc(sizeof(*cg));
+	if (cg == NULL) {
+		fprintf(stderr, "Couldn't allocate CompactGraph!\n");
+		exit(EXIT_FAILURE);
+	}
+	int nV = GraphNumVertices(g);
+	cg->numNodes = nV;
+	cg->outStart = fillStarts(g, GraphOutIncident);
+	cg->inStart = fillStarts(g, GraphInIncident);
+	cg->numEdges = cg->outStart[nV];
+
+	chooseWidths(g, &cg->vertexBytes, &cg->weightBytes, &cg->weight);
+
+	cg->outTo = allocate(cg->numEdges, cg->vertexBytes);
+	cg->inFrom = allocate(cg->numEdges, cg->vertexBytes);
+	cg->outWeight = NULL;
+	cg->inWeight = NULL;
+	if (cg->weightBytes != 0) {
+		cg->outWeight = allocate(cg->numEdges, cg->weightBytes);
+		cg->inWeight = allocate(cg->numEdges, cg->weightBytes);
+	}
+	fillEdges(cg, g, GraphOutIncident, cg->outTo, cg->outWeight);
+	fillEdges(cg, g, GraphInIncident, cg->inFrom, cg->inWeight);
+	return cg;
+}
+
+void CompactGraphFree(CompactGraph cg) {
+	assert(cg != NULL);
+
+	free(cg->outStart);
+	free(cg->outTo);
+	free(cg->outWeight);
+	free(cg->inStart);
+	free(cg->inFrom);
+	free(cg->inWeight);
+	free(cg);
+}
+
+MemoryUsage CompactGraphMemoryUsage(CompactGraph cg) {
+	assert(cg != NULL);
+
+	return layoutMemoryUsage(cg->numNodes, cg->numEdges, cg->vertexBytes,
+	                         cg->weightBytes);
+}
+
+// O(V + E)
+MemoryUsage CompactGraphMemoryEstimate(Graph g) {
+	assert(g != NULL);
+
+	int vertexBytes;
+	int weightBytes;
+	int weight;
+	chooseWidths(g, &vertexBytes, &weightBytes, &weight);
+	size_t numEdges = 0;
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			numEdges++;
+		}
+	}
+	return layoutMemoryUsage(GraphNumVertices(g), numEdges, vertexBytes,
+	                         weightBytes);
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// picks the narrowest widths every vertex number and weight fit in
+// O(V + E)
+static void chooseWidths(Graph g, int *vertexBytes, int *weightBytes,
+                         int *weight) {
+	int nV = GraphNumVertices(g);
+	int minWeight = INT32_MAX;
+	int maxWeight = INT32_MIN;
+	for (Vertex v = 0; v < nV; v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			if (out->weight < minWeight) {
+				minWeight = out->weight;
+			}
+			if (out->weight > maxWeight) {
+				maxWeight = out->weight;
+			}
+		}
+	}
+	*vertexBytes = nV <= UINT16_MAX + 1 ? 2 : 4;
+	*weight = 0;
+	if (minWeight >= maxWeight) {
+		// with no edges every weight is the same too
+		*weightBytes = 0;
+		*weight = minWeight <= maxWeight ? minWeight : 1;
+	} else if (minWeight >= 0 && maxWeight <= UINT8_MAX) {
+		*weightBytes = 1;
+	} else if (minWeight >= 0 && maxWeight <= UINT16_MAX) {
+		*weightBytes = 2;
+	} else {
+		*weightBytes = 4;
+	}
+}
+
+// what a snapshot with the given shape holds, as allocated by
+// CompactGraphNew
+static MemoryUsage layoutMemoryUsage(int numNodes, size_t numEdges,
+                                     int vertexBytes, int weightBytes) {
+	size_t numItems = numEdges > 0 ? numEdges : 1;
+	MemoryUsage m = {0};
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(struct CompactGraphRep));
+	MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 2, (numNodes + 1) * sizeof(int));
+	MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 2, numItems * vertexBytes);
+	if (weightBytes != 0) {
+		MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 2, numItems * weightBytes);
+	}
+	return m;
+}
+
+// mallocs an array, of at least one item so an empty graph isn't NULL
+static void *allocate(size_t count, size_t size) {
+	void *array = malloc((count > 0 ? count : 1) * size);
+	if (array == NULL) {
+		fprintf(stderr, "Couldn't allocate CompactGraph!\n");
+		exit(EXIT_FAILURE);
+	}
+	return array;
+}
+
+// returns where each vertex's edges start, with the number of edges at
+// the end
+// O(V + E)
+static int *fillStarts(Graph g, AdjList (*incident)(Graph, Vertex)) {
+	int nV = GraphNumVertices(g);
+	int *start = allocate(nV + 1, sizeof(int));
+	start[0] = 0;
+	for (Vertex v = 0; v < nV; v++) {
+		int degree = 0;
+		for (AdjList curr = incident(g, v); curr != NULL; curr = curr->next) {
+			degree++;
+		}
+		start[v + 1] = start[v] + degree;
+	}
+	return start;
+}
+
+// copies each vertex's edges into the arrays, in list order
+// O(V + E)
+static void fillEdges(CompactGraph cg, Graph g,
+                      AdjList (*incident)(Graph, Vertex), void *vertices,
+                      void *weights) {
+	int e = 0;
+	for (Vertex v = 0; v < cg->numNodes; v++) {
+		for (AdjList curr = incident(g, v); curr != NULL; curr = curr->next) {
+			setVertex(vertices, cg->vertexBytes, e, curr->v);
+			setWeight(weights, cg->weightBytes, e, curr->weight);
+			e++;
+		}
+	}
+}
+
+static void setVertex(void *vertices, int vertexBytes, int e, Vertex v) {
+	if (vertexBytes == 2) {
+		((uint16_t *)vertices)[e] = (uint16_t)v;
+	} else {
+		((Vertex *)vertices)[e] = v;
+	}
+}
+
+static void setWeight(void *weights, int weightBytes, int e, int weight) {
+	switch (weightBytes) {
+		case 0:
+			break;
+		case 1:
+			((uint8_t *)weights)[e] = (uint8_t)weight;
+			break;
+		case 2:
+			((uint16_t *)weights)[e] = (uint16_t)weight;
+			break;
+		default:
+			((int *)weights)[e] = weight;
+			break;
+	}
+}
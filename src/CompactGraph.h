@@ -0,0 +1,107 @@
+// Compressed read only snapshot of a graph
+// COMP2521 Assignment 2
+
+// The adjacency lists of a Graph spend a 16 byte node (plus the
+// allocator's header) on every edge in each direction, and following
+// them jumps all over memory. A CompactGraph stores the same edges as
+// arrays (CSR), with each vertex number in 2 bytes when the graph has at
+// most 65536 vertices and each weight in 1 or 2 bytes when every weight
+// fits, or not at all when every edge has the same weight. An edge then
+// takes 2 to 8 bytes per direction.
+//
+// The widths are only known once the graph has been read, so kernels
+// that walk the edges are written as always_inline functions taking the
+// widths as their last two arguments, and called through COMPACT_DISPATCH,
+// which passes them as constants. The compiler makes one copy of the
+// kernel for each layout, with the width checks folded away.
+//
+// The snapshot does not follow later changes to the graph.
+
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Graph.h"
+#include "MemoryUsage.h"
+
+typedef struct CompactGraphRep *CompactGraph;
+struct CompactGraphRep {
+	int numNodes;
+	int numEdges;
+
+	int vertexBytes;  // 2 or 4, the size of each entry of outTo/inFrom
+	int weightBytes;  // 1, 2 or 4, the size of each entry of outWeight/
+	                  // inWeight, or 0 if every edge has the same weight
+	int weight;       // the weight of every edge when weightBytes is 0
+
+	int *outStart;    // the edges out of v are outStart[v] up to
+	void *outTo;      // outStart[v + 1] - 1, ordered by vertex number
+	void *outWeight;  // (NULL when weightBytes is 0)
+
+	int *inStart;     // the same for the edges into each vertex
+	void *inFrom;
+	void *inWeight;
+};
+
+/**
+ * Takes a snapshot of the given graph, choosing the narrowest widths its
+ * vertices and weights fit in.
+ */
+CompactGraph CompactGraphNew(Graph g);
+
+/**
+ * Frees all memory associated with the given snapshot.
+ */
+void CompactGraphFree(CompactGraph cg);
+
+/**
+ * Returns the memory held by the given snapshot.
+ */
+MemoryUsage CompactGraphMemoryUsage(CompactGraph cg);
+
+/**
+ * Returns the memory a snapshot of the given graph would hold, without
+ * taking it.
+ */
+MemoryUsage CompactGraphMemoryEstimate(Graph g);
+
+// The vertex at index e of an outTo/inFrom array
+static inline Vertex compactVertex(const void *vertices, int vertexBytes,
+                                   int e) {
+	if (vertexBytes == 2) {
+		return ((const uint16_t *)vertices)[e];
+	}
+	return ((const Vertex *)vertices)[e];
+}
+
+// The weight at index e of an outWeight/inWeight array
+static inline int compactWeight(CompactGraph cg, const void *weights,
+                                int weightBytes, int e) {
+	switch (weightBytes) {
+		case 0:  return cg->weight;
+		case 1:  return ((const uint8_t *)weights)[e];
+		case 2:  return ((const uint16_t *)weights)[e];
+		default: return ((const int *)weights)[e];
+	}
+}
+
+// Calls kernel(..., vertexBytes, weightBytes) with the widths of cg as
+// constants
+#define COMPACT_DISPATCH(cg, kernel, ...)                                   \
+	do {                                                                    \
+		int layout_ = (cg)->vertexBytes * 8 + (cg)->weightBytes;            \
+		switch (layout_) {                                                  \
+			case 16: kernel(__VA_ARGS__, 2, 0); break;                      \
+			case 17: kernel(__VA_ARGS__, 2, 1); break;                      \
+			case 18: kernel(__VA_ARGS__, 2, 2); break;                      \
+			case 20: kernel(__VA_ARGS__, 2, 4); break;                      \
+			case 32: kernel(__VA_ARGS__, 4, 0); break;                      \
+			case 33: kernel(__VA_ARGS__, 4, 1); break;                      \
+			case 34: kernel(__VA_ARGS__, 4, 2); break;                      \
+			default: kernel(__VA_ARGS__, 4, 4); break;                      \
+		}                                                                   \
+	} while (0)
+
+#endif
@@ -0,0 +1,291 @@
+// Strongly and weakly connected components implementation
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Components.h"
+#include "Graph.h"
+#include "GraphExt.h"
+
+// one vertex on the search stack of Tarjan's algorithm, and the next of
+// its out edges to follow
+typedef struct frame {
+	Vertex v;
+	AdjList next;
+} Frame;
+
+// an edge of the condensation, before duplicates are dropped
+typedef struct componentEdge {
+	int from;
+	int to;
+	int weight;
+} ComponentEdge;
+
+static Components newComponents(int nV);
+static void fillMembers(Components *c);
+static void *allocate(size_t count, size_t size);
+static int componentEdgeCompare(const void *a, const void *b);
+
+// O(V + E)
+// Tarjan's algorithm with its own stack of frames in place of recursion.
+// A vertex's low is the smallest index it can reach back to through the
+// vertices still on the component stack; a vertex whose low is its own
+// index is the first one seen of its component, which is everything
+// above it on that stack
+Components stronglyConnectedComponents(Graph g) {
+	assert(g != NULL);
+
+	int nV = GraphNumVertices(g);
+	Components c = newComponents(nV);
+	int *index = allocate(nV, sizeof(int));
+	int *low = allocate(nV, sizeof(int));
+	bool *onStack = allocate(nV, sizeof(bool));
+	Vertex *stack = allocate(nV, sizeof(Vertex));
+	Frame *frames = allocate(nV, sizeof(Frame));
+	for (Vertex v = 0; v < nV; v++) {
+		index[v] = -1;
+		onStack[v] = false;
+	}
+
+	int numSeen = 0;
+	int stackSize = 0;
+	for (Vertex root = 0; root < nV; root++) {
+		if (index[root] != -1) {
+			continue;
+		}
+		int depth = 0;
+		frames[depth++] = (Frame) {root, GraphOutIncident(g, root)};
+		index[root] = low[root] = numSeen++;
+		stack[stackSize++] = root;
+		onStack[root] = true;
+
+		while (depth > 0) {
+			Frame *f = &frames[depth - 1];
+			Vertex v = f->v;
+			if (f->next != NULL) {
+				Vertex w = f->next->v;
+				f->next = f->next->next;
+				if (index[w] == -1) {
+					index[w] = low[w] = numSeen++;
+					stack[stackSize++] = w;
+					onStack[w] = true;
+					frames[depth++] = (Frame) {w, GraphOutIncident(g, w)};
+				} else if (onStack[w] && index[w] < low[v]) {
+					low[v] = index[w];
+				}
+				continue;
+			}
+
+			// every edge of v has been followed
+			depth--;
+			if (low[v] == index[v]) {
+				Vertex w;
+				do {
+					w = stack[--stackSize];
+					onStack[w] = false;
+					c.component[w] = c.numComponents;
+				} while (w != v);
+				c.numComponents++;
+			}
+			if (depth > 0) {
+				Vertex parent = frames[depth - 1].v;
+				if (low[v] < low[parent]) {
+					low[parent] = low[v];
+				}
+			}
+		}
+	}
+	free(index);
+	free(low);
+	free(onStack);
+	free(stack);
+	free(frames);
+
+	fillMembers(&c);
+	return c;
+}
+
+// O(V + E)
+// breadth first search along edges in both directions from each vertex
+// not yet in a component
+Components weaklyConnectedComponents(Graph g) {
+	assert(g != NULL);
+
+	int nV = GraphNumVertices(g);
+	Components c = newComponents(nV);
+	Vertex *queue = allocate(nV, sizeof(Vertex));
+	for (Vertex v = 0; v < nV; v++) {
+		c.component[v] = -1;
+	}
+
+	for (Vertex root = 0; root < nV; root++) {
+		if (c.component[root] != -1) {
+			continue;
+		}
+		int head = 0;
+		int tail = 0;
+		c.component[root] = c.numComponents;
+		queue[tail++] = root;
+		while (head < tail) {
+			Vertex v = queue[head++];
+			for (int dir = 0; dir < 2; dir++) {
+				AdjList l = dir == 0 ? GraphOutIncident(g, v) :
+				                       GraphInIncident(g, v);
+				for (; l != NULL; l = l->next) {
+					if (c.component[l->v] == -1) {
+						c.component[l->v] = c.numComponents;
+						queue[tail++] = l->v;
+					}
+				}
+			}
+		}
+		c.numComponents++;
+	}
+	free(queue);
+
+	fillMembers(&c);
+	return c;
+}
+
+int componentSize(Components c, int i) {
+	assert(i >= 0 && i < c.numComponents);
+	return c.start[i + 1] - c.start[i];
+}
+
+// O(size + E' log E'), where E' is the number of edges out of the
+// component's vertices
+Graph componentSubgraph(Graph g, Components c, int i) {
+	assert(g != NULL);
+	assert(i >= 0 && i < c.numComponents);
+
+	Graph sub = GraphNew(componentSize(c, i));
+	GraphBatch b = GraphBatchNew();
+	for (int j = c.start[i]; j < c.start[i + 1]; j++) {
+		Vertex v = c.members[j];
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			if (c.component[out->v] == i) {
+				GraphBatchInsertEdge(b, c.rank[v], c.rank[out->v],
+				                     out->weight);
+			}
+		}
+	}
+	GraphBatchApply(sub, b);
+	GraphBatchFree(b);
+	return sub;
+}
+
+// O(V + E log E)
+Graph condensationGraph(Graph g, Components scc) {
+	assert(g != NULL);
+
+	int nV = GraphNumVertices(g);
+	int numEdges = 0;
+	for (Vertex v = 0; v < nV; v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			numEdges++;
+		}
+	}
+	ComponentEdge *edges = allocate(numEdges, sizeof(ComponentEdge));
+	int numCross = 0;
+	for (Vertex v = 0; v < nV; v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			if (scc.component[v] != scc.component[out->v]) {
+				edges[numCross++] = (ComponentEdge) {
+					scc.component[v], scc.component[out->v], out->weight
+				};
+			}
+		}
+	}
+	// the lightest edge between two components comes first, and only
+	// the first insertion of an edge counts
+	qsort(edges, numCross, sizeof(ComponentEdge), componentEdgeCompare);
+
+	Graph dag = GraphNew(scc.numComponents > 0 ? scc.numComponents : 1);
+	GraphBatch b = GraphBatchNew();
+	for (int e = 0; e < numCross; e++) {
+		GraphBatchInsertEdge(b, edges[e].from, edges[e].to, edges[e].weight);
+	}
+	GraphBatchApply(dag, b);
+	GraphBatchFree(b);
+	free(edges);
+	return dag;
+}
+
+void freeComponents(Components c) {
+	free(c.component);
+	free(c.start);
+	free(c.members);
+	free(c.rank);
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// allocates the per vertex arrays, with no components yet
+static Components newComponents(int nV) {
+	Components c;
+	c.numNodes = nV;
+	c.numComponents = 0;
+	c.component = allocate(nV, sizeof(int));
+	c.start = NULL;
+	c.members = allocate(nV, sizeof(Vertex));
+	c.rank = allocate(nV, sizeof(int));
+	return c;
+}
+
+// counting sort of the vertices by component, which keeps each
+// component's vertices in increasing order
+// O(V)
+static void fillMembers(Components *c) {
+	c->start = allocate(c->numComponents + 1, sizeof(int));
+	for (int i = 0; i <= c->numComponents; i++) {
+		c->start[i] = 0;
+	}
+	for (Vertex v = 0; v < c->numNodes; v++) {
+		c->start[c->component[v] + 1]++;
+	}
+	for (int i = 0; i < c->numComponents; i++) {
+		c->start[i + 1] = c->start[i + 1] + c->start[i];
+	}
+	int *next = allocate(c->numComponents, sizeof(int));
+	for (int i = 0; i < c->numComponents; i++) {
+		next[i] = c->start[i];
+	}
+	for (Vertex v = 0; v < c->numNodes; v++) {
+		int i = c->component[v];
+		c->rank[v] = next[i] - c->start[i];
+		c->members[next[i]++] = v;
+	}
+	free(next);
+}
+
+// mallocs an array of at least one item
+static void *allocate(size_t count, size_t size) {
+	void *array = malloc((count > 0 ? count : 1) * size);
+	if (array == NULL) {
+		fprintf(stderr, "Couldn't allocate components!\n");
+		exit(EXIT_FAILURE);
+	}
+	return array;
+}
+
+// qsort comparator ordering condensation edges by their ends, lightest
+// first
+static int componentEdgeCompare(const void *a, const void *b) {
+	const ComponentEdge *x = a;
+	const ComponentEdge *y = b;
+	if (x->from != y->from) {
+		return x->from < y->from ? -1 : 1;
+	}
+	if (x->to != y->to) {
+		return x->to < y->to ? -1 : 1;
+	}
+	return (x->weight > y->weight) - (x->weight < y->weight);
+}
@@ -0,0 +1,68 @@
+// Strongly and weakly connected components
+// COMP2521 Assignment 2
+
+// A shortest path search never leaves the weakly connected component of
+// its source, and only reaches the strongly connected components below
+// its own in the condensation (the graph of components, which has no
+// cycles). The centrality measures use these to skip searches that
+// can't find anything and to work on each component on its own.
+//
+// Both are found without recursion, so long paths can't overflow the
+// stack.
+
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "Graph.h"
+
+typedef struct Components {
+	int numNodes;       // The number of vertices in the graph
+	int numComponents;
+	int *component;     // component[v] is the component v is in, from 0
+	                    // to numComponents - 1
+	int *start;         // the vertices of component i are members[start[i]]
+	Vertex *members;    // up to members[start[i + 1] - 1], in increasing
+	                    // order
+	int *rank;          // rank[v] is the position of v among the vertices
+	                    // of its own component
+} Components;
+
+/**
+ * Finds the strongly connected components of the given graph (Tarjan).
+ * They are numbered in reverse topological order: every edge between
+ * two components goes from a higher numbered one to a lower one.
+ */
+Components stronglyConnectedComponents(Graph g);
+
+/**
+ * Finds the weakly connected components of the given graph, the ones
+ * joined by edges in either direction, numbered in order of their lowest
+ * vertex.
+ */
+Components weaklyConnectedComponents(Graph g);
+
+/**
+ * Returns the number of vertices in component i.
+ */
+int componentSize(Components c, int i);
+
+/**
+ * Returns a new graph of just the vertices in component i and the edges
+ * between them, where vertex j is members[start[i] + j].
+ */
+Graph componentSubgraph(Graph g, Components c, int i);
+
+/**
+ * Returns the condensation of the graph for its strongly connected
+ * components: vertex i is component i, with an edge from i to j if any
+ * edge goes from a vertex of i to a vertex of j, weighted by the
+ * lightest such edge.
+ */
+Graph condensationGraph(Graph g, Components scc);
+
+/**
+ * Frees all memory associated with the given Components structure.
+ */
+void freeComponents(Components c);
+
+#endif
@@ -3,23 +3,38 @@
 // z5311885
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "Dijkstra.h"
+#include "DijkstraExt.h"
 #include "Graph.h"
 #include "PQ.h"
+#include "PQExt.h"
+#include "Pool.h"
+#include "Stats.h"
+
+// the block sps.pred points into: the pool the PredNodes come from sits
+// just before the lists, as ShortestPaths has no field for it
+typedef struct predArray {
+	Pool pool;
+	PredNode *lists[];
+} PredArray;
 
 // function 
 static ShortestPaths setupSPS(Graph g, Vertex src);
 static PredNode* insertPred(PredNode *head, PredNode *insert);
-static void freePredList(PredNode *head);
-static PredNode *newPred(Vertex v);
+static void freePredList(Pool p, PredNode *head);
+static PredNode *newPred(Pool p, Vertex v);
 static void printPred(PredNode *node);
+static PredArray *predArray(ShortestPaths sps);
+static MemoryUsage arraysMemoryUsage(int numNodes);
 
 // this function is an implementation of dijkstra's algo, using a priority queue
 // it returns a struct ShortestPaths which contains everything you could need
 // for finding paths, including the shortest path in a graph from a source vertex
+// all of the PredNodes come from one pool, which freeShortestPaths frees whole
 ShortestPaths dijkstra(Graph g, Vertex src) {
 	if(g == NULL) {
 		fprintf(stderr, "Invalid graph\n");
@@ -27,8 +42,11 @@ ShortestPaths dijkstra(Graph g, Vertex src) {
 		fprintf(stderr, "Invalid source vertex\n");
 	}
 	
+	STATS_TIMER(start);
 	ShortestPaths sps = setupSPS(g, src);
 	PQ q = PQNew();
+	Pool pool = PoolNew(sizeof(PredNode));
+	predArray(sps)->pool = pool;
 
 	// O(numNodes)
 	// Adding all outNodes to PQ
@@ -48,14 +66,16 @@ ShortestPaths dijkstra(Graph g, Vertex src) {
 			int alt = sps.dist[u] + curr->weight;
 			// checking that there isn't an integer overflow
 			if(sps.dist[u] != INFINITY) {
+				STATS_ADD(STATS_RELAXATIONS, 1);
 				if(alt < sps.dist[curr->v]) {
+					STATS_ADD(STATS_PRED_REBUILDS, 1);
 					sps.dist[curr->v] = alt;
 					// replacing the path as there is a shorter one
-					freePredList(sps.pred[curr->v]);
-					sps.pred[curr->v] = insertPred(NULL , newPred(u));
+					freePredList(pool, sps.pred[curr->v]);
+					sps.pred[curr->v] = insertPred(NULL , newPred(pool, u));
 					PQUpdate(q, curr->v, alt);
 				} else if (alt == sps.dist[curr->v]) {
-					sps.pred[curr->v] = insertPred(sps.pred[curr->v], newPred(u));
+					sps.pred[curr->v] = insertPred(sps.pred[curr->v], newPred(pool, u));
 					PQUpdate(q, curr->v, alt);
 				}
 			}
@@ -64,6 +84,7 @@ ShortestPaths dijkstra(Graph g, Vertex src) {
 		
 	}
 	PQFree(q);
+	STATS_TIMER_STOP(start, STATS_DIJKSTRA);
 
 	return sps;
 }
@@ -87,14 +108,43 @@ void showShortestPaths(ShortestPaths sps) {
 }
 
 void freeShortestPaths(ShortestPaths sps) {
-	for(int i = 0; i < sps.numNodes; i++) {
-		freePredList(sps.pred[i]);
+	if (sps.pred != NULL) {
+		PredArray *block = predArray(sps);
+		PoolFree(block->pool);
+		free(block);
 	}
-	free(sps.pred);
 	free(sps.dist);
 }
 
 
+// O(pool chunks)
+MemoryUsage shortestPathsMemoryUsage(ShortestPaths sps) {
+	MemoryUsage m = arraysMemoryUsage(sps.numNodes);
+	if (sps.pred != NULL) {
+		MemoryCombine(&m, PoolMemoryUsage(predArray(sps)->pool,
+		                                  MEMORY_PRED_LISTS));
+	}
+	return m;
+}
+
+// the PQ holds every node, and a node's predecessors are at most its
+// in-edges, so there are never more PredNodes in use than edges
+// O(V + E)
+MemoryUsage dijkstraMemoryEstimate(Graph g) {
+	int nV = GraphNumVertices(g);
+	size_t numEdges = 0;
+	for (Vertex v = 0; v < nV; v++) {
+		for (AdjList curr = GraphOutIncident(g, v); curr != NULL;
+		     curr = curr->next) {
+			numEdges++;
+		}
+	}
+	MemoryUsage m = arraysMemoryUsage(nV);
+	MemoryCombine(&m, PQMemoryEstimate(nV));
+	MemoryCombine(&m, PoolMemoryEstimate(sizeof(PredNode), numEdges,
+	                                     MEMORY_PRED_LISTS));
+	return m;
+}
 
 
 // ========================
@@ -108,7 +158,9 @@ static ShortestPaths setupSPS(Graph g, Vertex src) {
 	sps.numNodes = GraphNumVertices(g);
 	sps.src = src;
 	sps.dist = malloc(sps.numNodes * sizeof(int));
-	sps.pred = malloc(sps.numNodes * sizeof(PredNode *));
+	PredArray *block = malloc(sizeof(PredArray) +
+	                          sps.numNodes * sizeof(PredNode *));
+	sps.pred = block == NULL ? NULL : block->lists;
 	if(sps.dist != NULL && sps.pred != NULL) {
 		for(int i = 0; i < sps.numNodes; i++) {
 				sps.dist[i] = INFINITY;
@@ -131,30 +183,43 @@ static PredNode* insertPred(PredNode *head, PredNode *insert) {
 	}
 }
 
-// recursive free function
-// O(1)
-static void freePredList(PredNode *head) {
-    if (head == NULL) {
-        return;
-    }
-    freePredList(head->next);
-    free(head);
+// gives every node of a list back to the pool
+// O(length of linked list)
+static void freePredList(Pool p, PredNode *head) {
+	while (head != NULL) {
+		PredNode *next = head->next;
+		PoolRelease(p, head);
+		head = next;
+	}
 }
 
 // sets up and return a new PredNode 
 // O(1)
-static PredNode *newPred(Vertex v) {
-	PredNode *newNode = malloc(sizeof(struct PredNode));
+static PredNode *newPred(Pool p, Vertex v) {
+	PredNode *newNode = PoolAlloc(p);
     newNode->v = v;
     newNode->next = NULL;
     return newNode;
 }
 // prints PredNodes
 static void printPred(PredNode *node) {
-	if (node == NULL) {
-		printf("NULL\n");
-	} else {
+	for (; node != NULL; node = node->next) {
 		printf("[%d]->", node->v);
 	}
-	printPred(node->next);
-}
\ No newline at end of file
+	printf("NULL\n");
+}
+
+// the block holding sps.pred and the pool its PredNodes came from
+// O(1)
+static PredArray *predArray(ShortestPaths sps) {
+	return (PredArray *)((char *)sps.pred - offsetof(PredArray, lists));
+}
+
+// the distance and predecessor arrays of a ShortestPaths
+static MemoryUsage arraysMemoryUsage(int numNodes) {
+	MemoryUsage m = {0};
+	MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, numNodes * sizeof(int));
+	MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1,
+	          sizeof(PredArray) + numNodes * sizeof(PredNode *));
+	return m;
+}
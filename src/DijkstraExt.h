@@ -0,0 +1,27 @@
+// Dijkstra API extensions
+// COMP2521 Assignment 2
+
+// Memory accounting for dijkstra, added on top of Dijkstra.h, which is
+// fixed by the assignment and so left exactly as it was given.
+
+#ifndef DIJKSTRA_EXT_H
+#define DIJKSTRA_EXT_H
+
+#include "Dijkstra.h"
+#include "Graph.h"
+#include "MemoryUsage.h"
+
+/**
+ * Returns  the  memory  held  by  the given ShortestPaths structure: the
+ * distance and predecessor arrays and the predecessor list nodes.
+ */
+MemoryUsage shortestPathsMemoryUsage(ShortestPaths sps);
+
+/**
+ * Returns  (an upper bound on) the most memory dijkstra(g, src) holds at
+ * once,  for  any  src,  including  the  ShortestPaths it returns. Every
+ * edge is assumed to end up in a predecessor list.
+ */
+MemoryUsage dijkstraMemoryEstimate(Graph g);
+
+#endif
@@ -5,17 +5,45 @@
 
 // !!! DO NOT MODIFY THIS FILE !!!
 
+// for glibc's writer preferring read-write locks
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "Graph.h"
+#include "GraphExt.h"
 
 struct GraphRep{
 	int nV;
 	AdjList *outLinks;
 	AdjList *inLinks;
+	pthread_rwlock_t lock;  // held for writing while the lists change
+};
+
+#define BATCH_INSERT 0
+#define BATCH_REMOVE 1
+#define BATCH_UPDATE 2
+
+// One change in a batch. Once applied, the changes that actually altered
+// the graph are kept in the same form, with at most one per edge.
+typedef struct batchOp {
+	Vertex src;
+	Vertex dest;
+	int weight;
+	int kind;   // BATCH_INSERT, BATCH_REMOVE or BATCH_UPDATE
+	int order;  // the position it was added in, to keep that order
+} BatchOp;
+
+struct GraphBatchRep {
+	BatchOp *ops;
+	int numOps;
+	int capacity;
+	Vertex *touched;
+	int numTouched;
 };
 
 static bool validVertex(Graph g, Vertex v);
@@ -25,6 +53,19 @@ static AdjList adjListDelete(AdjList l, Vertex v);
 static bool inAdjList(AdjList l, Vertex v);
 static void freeAdjList(AdjList l);
 static void showAdjList(AdjList l);
+static size_t adjListLength(AdjList l);
+static void freeNodes(AdjList l);
+static AdjList takeNode(AdjList *spare, Vertex v, int weight);
+static void batchAdd(GraphBatch b, Vertex src, Vertex dest, int weight,
+                     int kind);
+static int mergeOutLists(Graph g, BatchOp *ops, int numOps,
+                         BatchOp *changes, AdjList *spare, AdjList *removed);
+static void mergeInLists(Graph g, BatchOp *changes, int numChanges,
+                         AdjList *spare, AdjList *removed);
+static int findTouched(GraphBatch b, BatchOp *changes, int numChanges);
+static int bySrc(const void *a, const void *b);
+static int byDest(const void *a, const void *b);
+static int vertexCompare(const void *a, const void *b);
 
 ////////////////////////////////////////////////////////////////////////
 // Constructor/Destructor
@@ -42,7 +83,16 @@ Graph GraphNew(int nVertices) {
 	g->outLinks = calloc(nVertices, sizeof(AdjList));
 	g->inLinks  = calloc(nVertices, sizeof(AdjList));
 
-	if (g->outLinks == NULL || g->inLinks == NULL) {
+	// a steady stream of readers mustn't hold off a batch for ever
+	pthread_rwlockattr_t attr;
+	pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+	pthread_rwlockattr_setkind_np(&attr,
+	                              PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+	int error = pthread_rwlock_init(&g->lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
+	if (g->outLinks == NULL || g->inLinks == NULL || error != 0) {
 		fprintf(stderr, "Couldn't allocate Graph!\n");
 		exit(EXIT_FAILURE);
 	}
@@ -60,6 +110,7 @@ void GraphFree(Graph g) {
 	}
 	free(g->outLinks);
 	free(g->inLinks);
+	pthread_rwlock_destroy(&g->lock);
 	free(g);
 }
 
@@ -72,8 +123,10 @@ void GraphInsertEdge(Graph g, Vertex src, Vertex dest, int weight) {
 	assert(validVertex(g, dest));
 	assert(weight > 0);
 
+	pthread_rwlock_wrlock(&g->lock);
 	g->outLinks[src] = adjListInsert(g->outLinks[src], dest, weight);
 	g->inLinks[dest] = adjListInsert(g->inLinks[dest], src, weight);
+	pthread_rwlock_unlock(&g->lock);
 }
 
 void GraphRemoveEdge(Graph g, Vertex src, Vertex dest) {
@@ -81,8 +134,10 @@ void GraphRemoveEdge(Graph g, Vertex src, Vertex dest) {
 	assert(validVertex(g, src));
 	assert(validVertex(g, dest));
 
+	pthread_rwlock_wrlock(&g->lock);
 	g->outLinks[src] = adjListDelete(g->outLinks[src], dest);
 	g->inLinks[dest] = adjListDelete(g->inLinks[dest], src);
+	pthread_rwlock_unlock(&g->lock);
 }
 
 bool GraphIsAdjacent(Graph g, Vertex src, Vertex dest) {
@@ -112,6 +167,136 @@ AdjList GraphInIncident(Graph g, Vertex v) {
 	return g->inLinks[v];
 }
 
+////////////////////////////////////////////////////////////////////////
+// Batched Graph Operations
+
+GraphBatch GraphBatchNew(void) {
+	GraphBatch b = malloc(sizeof(*b));
+	if (b == NULL) {
+		fprintf(stderr, "Couldn't allocate GraphBatch!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	b->ops = NULL;
+	b->numOps = 0;
+	b->capacity = 0;
+	b->touched = NULL;
+	b->numTouched = 0;
+	return b;
+}
+
+void GraphBatchFree(GraphBatch b) {
+	assert(b != NULL);
+
+	free(b->ops);
+	free(b->touched);
+	free(b);
+}
+
+void GraphBatchInsertEdge(GraphBatch b, Vertex src, Vertex dest, int weight) {
+	batchAdd(b, src, dest, weight, BATCH_INSERT);
+}
+
+void GraphBatchRemoveEdge(GraphBatch b, Vertex src, Vertex dest) {
+	batchAdd(b, src, dest, 0, BATCH_REMOVE);
+}
+
+void GraphBatchUpdateWeight(GraphBatch b, Vertex src, Vertex dest,
+                            int weight) {
+	batchAdd(b, src, dest, weight, BATCH_UPDATE);
+}
+
+// O(B log B + V' + E'), for B changes touching lists of E' edges in all
+// from V' vertices
+// The changes are sorted by source and merged into each out-list in one
+// walk. The net changes that walk makes (at most one per edge) are then
+// sorted by destination and merged into the in-lists the same way.
+// Every node the batch could add is allocated before the write lock is
+// taken, and the nodes it removes are only freed once it is released, so
+// readers are kept out for just the relinking.
+int GraphBatchApply(Graph g, GraphBatch b) {
+	assert(g != NULL && b != NULL);
+
+	// nothing is changed until every change is known to be valid
+	int numInserts = 0;
+	for (int i = 0; i < b->numOps; i++) {
+		BatchOp op = b->ops[i];
+		if (!validVertex(g, op.src) || !validVertex(g, op.dest) ||
+		    (op.kind != BATCH_REMOVE && op.weight <= 0)) {
+			return -1;
+		}
+		if (op.kind == BATCH_INSERT) {
+			numInserts++;
+		}
+	}
+
+	BatchOp *changes = malloc((b->numOps > 0 ? b->numOps : 1) *
+	                          sizeof(BatchOp));
+	if (changes == NULL) {
+		fprintf(stderr, "Couldn't allocate batch changes!\n");
+		exit(EXIT_FAILURE);
+	}
+	// a node for each insertion in both lists, whether or not it happens
+	AdjList spare = NULL;
+	for (int i = 0; i < 2 * numInserts; i++) {
+		AdjList n = newAdjNode(0, 0);
+		n->next = spare;
+		spare = n;
+	}
+	// an empty batch has no ops array for qsort to be given
+	if (b->numOps > 0) {
+		qsort(b->ops, b->numOps, sizeof(BatchOp), bySrc);
+	}
+
+	AdjList removed = NULL;
+	pthread_rwlock_wrlock(&g->lock);
+	int numChanges = mergeOutLists(g, b->ops, b->numOps, changes, &spare,
+	                               &removed);
+	qsort(changes, numChanges, sizeof(BatchOp), byDest);
+	mergeInLists(g, changes, numChanges, &spare, &removed);
+	pthread_rwlock_unlock(&g->lock);
+	freeNodes(spare);
+	freeNodes(removed);
+
+	b->numTouched = findTouched(b, changes, numChanges);
+	b->numOps = 0;
+	free(changes);
+	return b->numTouched;
+}
+
+const Vertex *GraphBatchTouched(GraphBatch b) {
+	assert(b != NULL);
+	return b->touched;
+}
+
+void GraphReadLock(Graph g) {
+	assert(g != NULL);
+	pthread_rwlock_rdlock(&g->lock);
+}
+
+void GraphReadUnlock(Graph g) {
+	assert(g != NULL);
+	pthread_rwlock_unlock(&g->lock);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Memory
+
+MemoryUsage GraphMemoryUsage(Graph g) {
+	assert(g != NULL);
+
+	MemoryUsage m = {0};
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(*g));
+	MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 2, g->nV * sizeof(AdjList));
+	for (Vertex i = 0; i < g->nV; i++) {
+		MemoryAdd(&m, MEMORY_OUT_LISTS, adjListLength(g->outLinks[i]),
+		          sizeof(struct adjListNode));
+		MemoryAdd(&m, MEMORY_IN_LISTS, adjListLength(g->inLinks[i]),
+		          sizeof(struct adjListNode));
+	}
+	return m;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Debugging
 
@@ -225,3 +410,214 @@ static void showAdjList(AdjList l) {
 	printf("X\n");
 }
 
+
+/**
+ * Returns the number of nodes in the given adjacency list.
+ */
+static size_t adjListLength(AdjList l) {
+	size_t length = 0;
+	for (; l != NULL; l = l->next) {
+		length++;
+	}
+	return length;
+}
+
+/**
+ * Frees a list of nodes without recursing, as the spare and removed
+ * nodes of a large batch can make a very long list.
+ */
+static void freeNodes(AdjList l) {
+	while (l != NULL) {
+		AdjList next = l->next;
+		free(l);
+		l = next;
+	}
+}
+
+/**
+ * Takes a node allocated ahead of time off the spare list and fills it in.
+ */
+static AdjList takeNode(AdjList *spare, Vertex v, int weight) {
+	AdjList n = *spare;
+	assert(n != NULL);
+	*spare = n->next;
+	n->v = v;
+	n->weight = weight;
+	n->next = NULL;
+	return n;
+}
+
+/**
+ * Appends a change to the batch, doubling its array when it is full.
+ */
+static void batchAdd(GraphBatch b, Vertex src, Vertex dest, int weight,
+                     int kind) {
+	assert(b != NULL);
+
+	if (b->numOps == b->capacity) {
+		b->capacity = b->capacity > 0 ? 2 * b->capacity : 64;
+		b->ops = realloc(b->ops, b->capacity * sizeof(BatchOp));
+		if (b->ops == NULL) {
+			fprintf(stderr, "Couldn't expand GraphBatch!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	b->ops[b->numOps] = (BatchOp) {src, dest, weight, kind, b->numOps};
+	b->numOps++;
+}
+
+/**
+ * Applies  the  changes,  sorted by source, destination and order, to the
+ * out-lists,  walking  each  list once. Every change to the same edge is
+ * folded  into  one  final state first. Writes the net changes made into
+ * 'changes' and returns how many there are. New nodes are taken from
+ * 'spare', and unlinked nodes are put on 'removed' rather than freed.
+ */
+static int mergeOutLists(Graph g, BatchOp *ops, int numOps,
+                         BatchOp *changes, AdjList *spare, AdjList *removed) {
+	int numChanges = 0;
+	int i = 0;
+	while (i < numOps) {
+		Vertex src = ops[i].src;
+		// link is the pointer to the first node not yet passed
+		AdjList *link = &g->outLinks[src];
+		for (; i < numOps && ops[i].src == src; ) {
+			Vertex dest = ops[i].dest;
+			while (*link != NULL && (*link)->v < dest) {
+				link = &(*link)->next;
+			}
+			AdjList node = (*link != NULL && (*link)->v == dest) ? *link : NULL;
+
+			bool exists = node != NULL;
+			int weight = exists ? node->weight : 0;
+			for (; i < numOps && ops[i].src == src && ops[i].dest == dest; i++) {
+				if (ops[i].kind == BATCH_INSERT && !exists) {
+					exists = true;
+					weight = ops[i].weight;
+				} else if (ops[i].kind == BATCH_REMOVE) {
+					exists = false;
+				} else if (ops[i].kind == BATCH_UPDATE && exists) {
+					weight = ops[i].weight;
+				}
+			}
+
+			if (node != NULL && !exists) {
+				*link = node->next;
+				node->next = *removed;
+				*removed = node;
+				changes[numChanges++] = (BatchOp) {src, dest, 0, BATCH_REMOVE, 0};
+			} else if (node == NULL && exists) {
+				AdjList n = takeNode(spare, dest, weight);
+				n->next = *link;
+				*link = n;
+				link = &n->next;
+				changes[numChanges++] = (BatchOp) {src, dest, weight,
+				                                   BATCH_INSERT, 0};
+			} else if (node != NULL && weight != node->weight) {
+				node->weight = weight;
+				changes[numChanges++] = (BatchOp) {src, dest, weight,
+				                                   BATCH_UPDATE, 0};
+			}
+		}
+	}
+	return numChanges;
+}
+
+/**
+ * Applies  the  net  changes,  sorted by destination and source, to the
+ * in-lists,  walking  each  list  once. The in-lists mirror the out-lists,
+ * so each change is known to apply.
+ */
+static void mergeInLists(Graph g, BatchOp *changes, int numChanges,
+                         AdjList *spare, AdjList *removed) {
+	int i = 0;
+	while (i < numChanges) {
+		Vertex dest = changes[i].dest;
+		AdjList *link = &g->inLinks[dest];
+		for (; i < numChanges && changes[i].dest == dest; i++) {
+			Vertex src = changes[i].src;
+			while (*link != NULL && (*link)->v < src) {
+				link = &(*link)->next;
+			}
+			if (changes[i].kind == BATCH_INSERT) {
+				AdjList n = takeNode(spare, src, changes[i].weight);
+				n->next = *link;
+				*link = n;
+				link = &n->next;
+			} else if (changes[i].kind == BATCH_REMOVE) {
+				AdjList node = *link;
+				assert(node != NULL && node->v == src);
+				*link = node->next;
+				node->next = *removed;
+				*removed = node;
+			} else {
+				assert(*link != NULL && (*link)->v == src);
+				(*link)->weight = changes[i].weight;
+			}
+		}
+	}
+}
+
+/**
+ * Records  every vertex at either end of a net change in the batch, in
+ * increasing order without repeats, and returns how many there are.
+ */
+static int findTouched(GraphBatch b, BatchOp *changes, int numChanges) {
+	free(b->touched);
+	b->touched = malloc((numChanges > 0 ? 2 * numChanges : 1) *
+	                    sizeof(Vertex));
+	if (b->touched == NULL) {
+		fprintf(stderr, "Couldn't allocate touched vertices!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < numChanges; i++) {
+		b->touched[2 * i] = changes[i].src;
+		b->touched[2 * i + 1] = changes[i].dest;
+	}
+	qsort(b->touched, 2 * numChanges, sizeof(Vertex), vertexCompare);
+
+	int numTouched = 0;
+	for (int i = 0; i < 2 * numChanges; i++) {
+		if (numTouched == 0 || b->touched[numTouched - 1] != b->touched[i]) {
+			b->touched[numTouched++] = b->touched[i];
+		}
+	}
+	return numTouched;
+}
+
+/**
+ * qsort comparator ordering changes by source, destination, then the
+ * order they were added in.
+ */
+static int bySrc(const void *a, const void *b) {
+	const BatchOp *x = a;
+	const BatchOp *y = b;
+	if (x->src != y->src) {
+		return x->src < y->src ? -1 : 1;
+	}
+	if (x->dest != y->dest) {
+		return x->dest < y->dest ? -1 : 1;
+	}
+	return (x->order > y->order) - (x->order < y->order);
+}
+
+/**
+ * qsort comparator ordering net changes by destination, then source.
+ */
+static int byDest(const void *a, const void *b) {
+	const BatchOp *x = a;
+	const BatchOp *y = b;
+	if (x->dest != y->dest) {
+		return x->dest < y->dest ? -1 : 1;
+	}
+	return (x->src > y->src) - (x->src < y->src);
+}
+
+/**
+ * qsort comparator for ascending vertices.
+ */
+static int vertexCompare(const void *a, const void *b) {
+	Vertex x = *(const Vertex *)a;
+	Vertex y = *(const Vertex *)b;
+	return (x > y) - (x < y);
+}
@@ -0,0 +1,365 @@
+// Header only C++ graph core
+// COMP2521 Assignment 2
+
+// A read only CSR graph whose vertex and weight types are template
+// parameters, with Dijkstra, closeness and betweenness written once as
+// templates over it. Graph<std::uint16_t, std::uint8_t> stores an edge
+// in 3 bytes per direction, a quarter of what Graph<std::uint64_t,
+// std::uint32_t> takes, and the 64 bit vertex ids reach past the int
+// Vertex of the C Graph. A weight type of Unit stores no weights at all,
+// and every search on it becomes a breadth first search at compile time
+// (if constexpr), with no heap.
+//
+// The C API (Graph.h, Dijkstra.h, CentralityMeasures.h) keeps working as
+// it is, on CompactGraph, which is the same layout with the widths picked
+// at run time. fromGraph takes a snapshot of a C Graph into this core,
+// and closeness/betweenness give what closenessCentrality/
+// betweennessCentrality give on it (betweenness up to floating point
+// rounding, as the in edges may be added up in another order).
+
+#ifndef GRAPH_CORE_HPP
+#define GRAPH_CORE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "Graph.h"
+}
+
+namespace graphcore {
+
+// The weight type of a graph where every edge weighs 1
+struct Unit {};
+
+template <typename VertexT, typename WeightT>
+class Graph {
+	static_assert(std::is_integral_v<VertexT> && std::is_unsigned_v<VertexT>,
+	              "vertex ids must be an unsigned integer type");
+	static_assert(std::is_same_v<WeightT, Unit> ||
+	              (std::is_integral_v<WeightT> && std::is_unsigned_v<WeightT>),
+	              "weights must be Unit or an unsigned integer type");
+
+public:
+	static constexpr bool unitWeights = std::is_same_v<WeightT, Unit>;
+
+	// Wide enough for the longest shortest path, with the largest value
+	// left over for "unreachable": a path has fewer than 2^(8 * sizeof
+	// (VertexT)) edges, each no heavier than the largest WeightT
+	using Distance = std::conditional_t<
+		unitWeights, VertexT,
+		std::conditional_t<sizeof(VertexT) + sizeof(WeightT) <= 4,
+		                   std::uint32_t, std::uint64_t>>;
+	static constexpr Distance unreachable = std::numeric_limits<Distance>::max();
+
+	struct Edge {
+		VertexT from;
+		VertexT to;
+		WeightT weight;
+	};
+
+	// O(V + E log E)
+	// Only the first of several edges between the same two vertices is
+	// kept, like GraphInsertEdge does. Throws std::invalid_argument for an
+	// edge with an end out of range or a weight of 0
+	Graph(VertexT numVertices, std::vector<Edge> edges) : nV(numVertices) {
+		for (const Edge &e : edges) {
+			if (e.from >= nV || e.to >= nV) {
+				throw std::invalid_argument("edge end out of range");
+			}
+			if constexpr (!unitWeights) {
+				if (e.weight == 0) {
+					throw std::invalid_argument("edge weight must be positive");
+				}
+			}
+		}
+		std::stable_sort(edges.begin(), edges.end(),
+		                 [](const Edge &x, const Edge &y) {
+			return x.from != y.from ? x.from < y.from : x.to < y.to;
+		});
+		edges.erase(std::unique(edges.begin(), edges.end(),
+		                        [](const Edge &x, const Edge &y) {
+			return x.from == y.from && x.to == y.to;
+		}), edges.end());
+
+		fill(edges, outStart, outTo, outWeight,
+		     [](const Edge &e) { return e.from; },
+		     [](const Edge &e) { return e.to; });
+		fill(edges, inStart, inFrom, inWeight,
+		     [](const Edge &e) { return e.to; },
+		     [](const Edge &e) { return e.from; });
+	}
+
+	VertexT numVertices() const { return nV; }
+	std::size_t numEdges() const { return outTo.size(); }
+
+	// Calls f(w, weight) for each edge v -> w, in order of w
+	template <typename F>
+	void forEachOut(VertexT v, F &&f) const {
+		forEach(outStart, outTo, outWeight, v, f);
+	}
+
+	// Calls f(u, weight) for each edge u -> v, in order of u
+	template <typename F>
+	void forEachIn(VertexT v, F &&f) const {
+		forEach(inStart, inFrom, inWeight, v, f);
+	}
+
+	// The bytes held by the offsets, vertex ids and weights
+	std::size_t memoryBytes() const {
+		std::size_t bytes = (outStart.size() + inStart.size()) *
+		                    sizeof(std::size_t) +
+		                    (outTo.size() + inFrom.size()) * sizeof(VertexT);
+		if constexpr (!unitWeights) {
+			bytes += (outWeight.size() + inWeight.size()) * sizeof(WeightT);
+		}
+		return bytes;
+	}
+
+private:
+	VertexT nV;
+	std::vector<std::size_t> outStart;  // the edges out of v are
+	std::vector<VertexT> outTo;         // outStart[v] up to outStart[v + 1]
+	std::vector<WeightT> outWeight;     // (empty for Unit weights)
+	std::vector<std::size_t> inStart;   // the same for the edges into v
+	std::vector<VertexT> inFrom;
+	std::vector<WeightT> inWeight;
+
+	// counting sort of the edges by key(e), keeping their order otherwise
+	template <typename Key, typename Other>
+	void fill(const std::vector<Edge> &edges, std::vector<std::size_t> &start,
+	          std::vector<VertexT> &ends, std::vector<WeightT> &weights,
+	          Key key, Other other) {
+		start.assign(static_cast<std::size_t>(nV) + 1, 0);
+		for (const Edge &e : edges) {
+			start[key(e) + 1]++;
+		}
+		for (std::size_t v = 0; v < nV; v++) {
+			start[v + 1] += start[v];
+		}
+		std::vector<std::size_t> next(start.begin(), start.end() - 1);
+		ends.resize(edges.size());
+		if constexpr (!unitWeights) {
+			weights.resize(edges.size());
+		}
+		for (const Edge &e : edges) {
+			std::size_t i = next[key(e)]++;
+			ends[i] = other(e);
+			if constexpr (!unitWeights) {
+				weights[i] = e.weight;
+			}
+		}
+	}
+
+	template <typename F>
+	static void forEach(const std::vector<std::size_t> &start,
+	                    const std::vector<VertexT> &ends,
+	                    const std::vector<WeightT> &weights, VertexT v,
+	                    F &f) {
+		for (std::size_t i = start[v]; i < start[v + 1]; i++) {
+			if constexpr (unitWeights) {
+				f(ends[i], Distance{1});
+			} else {
+				f(ends[i], static_cast<Distance>(weights[i]));
+			}
+		}
+	}
+};
+
+// O(V + E)
+// Takes a snapshot of a C Graph. Throws std::out_of_range if a vertex or
+// weight doesn't fit the chosen types; with Unit weights, every edge must
+// weigh 1
+template <typename VertexT, typename WeightT>
+Graph<VertexT, WeightT> fromGraph(::Graph g) {
+	using Core = Graph<VertexT, WeightT>;
+	int nV = GraphNumVertices(g);
+	if (static_cast<std::uint64_t>(nV) >
+	    std::numeric_limits<VertexT>::max()) {
+		throw std::out_of_range("too many vertices for the vertex type");
+	}
+
+	std::vector<typename Core::Edge> edges;
+	for (Vertex v = 0; v < nV; v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			typename Core::Edge e{static_cast<VertexT>(v),
+			                      static_cast<VertexT>(out->v), WeightT{}};
+			if constexpr (Core::unitWeights) {
+				if (out->weight != 1) {
+					throw std::out_of_range("edge weight is not 1");
+				}
+			} else {
+				if (static_cast<std::uint64_t>(out->weight) >
+				    std::numeric_limits<WeightT>::max()) {
+					throw std::out_of_range("edge weight too large");
+				}
+				e.weight = static_cast<WeightT>(out->weight);
+			}
+			edges.push_back(e);
+		}
+	}
+	return Core(static_cast<VertexT>(nV), std::move(edges));
+}
+
+// The state of a single source search, kept so that it can be run again
+// from other sources without allocating. Like SSSP, but with the vertex,
+// distance and weight types of the graph
+template <typename VertexT, typename WeightT>
+class ShortestPaths {
+public:
+	using Core = Graph<VertexT, WeightT>;
+	using Distance = typename Core::Distance;
+
+	explicit ShortestPaths(const Core &g)
+		: g(g), distance(g.numVertices(), Core::unreachable),
+		  paths(g.numVertices(), 0), settled(g.numVertices(), false) {
+		order.reserve(g.numVertices());
+	}
+
+	// O((V + E) log V), or O(V + E) for Unit weights
+	// Fills in the distance to and the number of shortest paths to each
+	// vertex from src, and the vertices reached in the order they were
+	// settled, src first
+	void run(VertexT src) {
+		for (VertexT v : order) {
+			distance[v] = Core::unreachable;
+			paths[v] = 0;
+			settled[v] = false;
+		}
+		order.clear();
+		distance[src] = 0;
+		paths[src] = 1;
+
+		if constexpr (Core::unitWeights) {
+			// the queue is the settled order, already sorted by distance
+			settled[src] = true;
+			order.push_back(src);
+			for (std::size_t head = 0; head < order.size(); head++) {
+				VertexT v = order[head];
+				Distance next = distance[v] + 1;
+				g.forEachOut(v, [&](VertexT w, Distance) {
+					if (!settled[w]) {
+						settled[w] = true;
+						distance[w] = next;
+						order.push_back(w);
+					}
+					if (distance[w] == next) {
+						paths[w] += paths[v];
+					}
+				});
+			}
+		} else {
+			using Entry = std::pair<Distance, VertexT>;
+			std::priority_queue<Entry, std::vector<Entry>,
+			                    std::greater<Entry>> pq;
+			pq.push({0, src});
+			while (!pq.empty()) {
+				auto [d, v] = pq.top();
+				pq.pop();
+				if (settled[v] || d > distance[v]) {
+					continue;
+				}
+				settled[v] = true;
+				order.push_back(v);
+				g.forEachOut(v, [&](VertexT w, Distance weight) {
+					Distance alt = d + weight;
+					if (alt < distance[w]) {
+						distance[w] = alt;
+						paths[w] = paths[v];
+						pq.push({alt, w});
+					} else if (alt == distance[w]) {
+						paths[w] += paths[v];
+					}
+				});
+			}
+		}
+	}
+
+	// O(V + E)
+	// Sets delta[v] to the dependency of the last search's source on v,
+	// Brandes' sum of paths[u] / paths[v] * (1 + delta[v]) over the
+	// shortest path edges u -> v, worked back from the furthest vertex
+	void accumulate(std::vector<double> &delta) const {
+		for (VertexT v : order) {
+			delta[v] = 0;
+		}
+		for (std::size_t i = order.size(); i-- > 1; ) {
+			VertexT w = order[i];
+			double share = (1 + delta[w]) / paths[w];
+			g.forEachIn(w, [&](VertexT u, Distance weight) {
+				if (distance[u] != Core::unreachable &&
+				    distance[u] + weight == distance[w]) {
+					delta[u] += paths[u] * share;
+				}
+			});
+		}
+	}
+
+	Distance dist(VertexT v) const { return distance[v]; }
+	double numPaths(VertexT v) const { return paths[v]; }
+	const std::vector<VertexT> &settledOrder() const { return order; }
+
+private:
+	const Core &g;
+	std::vector<Distance> distance;
+	std::vector<double> paths;
+	std::vector<bool> settled;
+	std::vector<VertexT> order;
+};
+
+// O(V * (V + E) log V), or O(V * (V + E)) for Unit weights
+// The Wasserman and Faust closeness of every vertex, as in
+// closenessCentrality
+template <typename VertexT, typename WeightT>
+std::vector<double> closeness(const Graph<VertexT, WeightT> &g) {
+	std::size_t nV = g.numVertices();
+	std::vector<double> values(nV, 0);
+	ShortestPaths<VertexT, WeightT> sp(g);
+	for (std::size_t src = 0; src < nV; src++) {
+		sp.run(static_cast<VertexT>(src));
+		const std::vector<VertexT> &order = sp.settledOrder();
+		double distanceSum = 0;
+		for (std::size_t i = 1; i < order.size(); i++) {
+			distanceSum += sp.dist(order[i]);
+		}
+		// a vertex that reaches nothing has closeness 0
+		if (distanceSum != 0) {
+			double reached = static_cast<double>(order.size()) - 1;
+			values[src] = (reached * reached / (static_cast<double>(nV) - 1)) *
+			              (1 / distanceSum);
+		}
+	}
+	return values;
+}
+
+// O(V * (V + E) log V), or O(V * (V + E)) for Unit weights
+// Brandes' betweenness of every vertex, as in betweennessCentrality
+template <typename VertexT, typename WeightT>
+std::vector<double> betweenness(const Graph<VertexT, WeightT> &g) {
+	std::size_t nV = g.numVertices();
+	std::vector<double> values(nV, 0);
+	std::vector<double> delta(nV, 0);
+	ShortestPaths<VertexT, WeightT> sp(g);
+	for (std::size_t src = 0; src < nV; src++) {
+		sp.run(static_cast<VertexT>(src));
+		sp.accumulate(delta);
+		const std::vector<VertexT> &order = sp.settledOrder();
+		for (std::size_t i = 1; i < order.size(); i++) {
+			values[order[i]] += delta[order[i]];
+		}
+	}
+	return values;
+}
+
+} // namespace graphcore
+
+#endif
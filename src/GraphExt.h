@@ -0,0 +1,102 @@
+// Graph ADT interface extensions
+// COMP2521 Assignment 2
+
+// Operations added on top of Graph.h, which is fixed by the assignment
+// and so left exactly as it was given.
+
+#ifndef GRAPH_EXT_H
+#define GRAPH_EXT_H
+
+#include "Graph.h"
+#include "MemoryUsage.h"
+
+typedef struct GraphBatchRep *GraphBatch;
+
+////////////////////////////////////////////////////////////////////////
+// Batched Graph Operations
+
+// A batch collects edge changes and applies them together: the changes
+// are sorted by vertex, and each list they touch is walked only once,
+// instead of once per change. The batch is checked in full before the
+// graph is changed, so it is either applied whole or not at all, and
+// afterwards it records which vertices it changed. It is applied under
+// the graph's write lock, so a reader holding GraphReadLock sees the
+// graph either before the batch or after all of it.
+
+/**
+ * Creates an empty batch.
+ */
+GraphBatch GraphBatchNew(void);
+
+/**
+ * Frees all of the memory associated with the given batch.
+ */
+void GraphBatchFree(GraphBatch b);
+
+/**
+ * Adds  an  insertion  of  an  edge from 'src' to 'dest' with the given
+ * weight.  As  with GraphInsertEdge, it does nothing if the edge already
+ * exists by the time it is applied.
+ */
+void GraphBatchInsertEdge(GraphBatch b, Vertex src, Vertex dest, int weight);
+
+/**
+ * Adds  a  removal of the edge from 'src' to 'dest', which does nothing
+ * if there is no such edge by the time it is applied.
+ */
+void GraphBatchRemoveEdge(GraphBatch b, Vertex src, Vertex dest);
+
+/**
+ * Adds  a  change  to  the  weight of the edge from 'src' to 'dest',
+ * which does nothing if there is no such edge by the time it is applied.
+ */
+void GraphBatchUpdateWeight(GraphBatch b, Vertex src, Vertex dest,
+                            int weight);
+
+/**
+ * Applies  every  change  in  the  batch  to  the given graph, as if they
+ * were  made  one  at  a  time  in the order they were added, and empties
+ * the  batch  so  it  can be reused. Returns the number of vertices whose
+ * outgoing  or  incoming  edges  changed,  which  GraphBatchTouched then
+ * lists.
+ *
+ * Returns  -1,  leaving  both the graph and the batch as they were, if a
+ * change has a vertex that isn't in the graph, or an insertion or weight
+ * change has a weight that isn't positive.
+ */
+int GraphBatchApply(Graph g, GraphBatch b);
+
+/**
+ * Returns  the  vertices  changed  by  the  last GraphBatchApply, in
+ * increasing  order. The array belongs to the batch and is only valid
+ * until it is next applied or freed.
+ */
+const Vertex *GraphBatchTouched(GraphBatch b);
+
+////////////////////////////////////////////////////////////////////////
+// Concurrent Readers
+
+/**
+ * Takes  a read lock on the graph, which GraphBatchApply, GraphInsertEdge
+ * and  GraphRemoveEdge wait for before changing any list. Hold it while
+ * walking  the lists from another thread than the one changing them.
+ * Any number of readers can hold it at once.
+ */
+void GraphReadLock(Graph g);
+
+/**
+ * Releases a read lock taken with GraphReadLock.
+ */
+void GraphReadUnlock(Graph g);
+
+////////////////////////////////////////////////////////////////////////
+// Memory
+
+/**
+ * Returns  the  memory held by the given graph: the graph itself, the
+ * arrays  of  list  heads  and  a  node for every edge in each of the
+ * outgoing and incoming lists.
+ */
+MemoryUsage GraphMemoryUsage(Graph g);
+
+#endif
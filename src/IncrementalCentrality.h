@@ -0,0 +1,83 @@
+// Incrementally maintained centrality measures
+// COMP2521 Assignment 2
+
+// Keeps the closeness and betweenness centrality of a graph up to date
+// as edges are inserted and removed. The distances from every source are
+// kept, so after each edge change only the sources whose shortest paths
+// could have changed are searched again, once each; every other source's
+// share of the measures is reused as is. Each source's share is kept
+// apart and replaced whole, never adjusted, so rounding errors don't
+// build up over many updates.
+
+#ifndef INCREMENTAL_CENTRALITY_H
+#define INCREMENTAL_CENTRALITY_H
+
+#include <stdbool.h>
+
+#include "CentralityMeasures.h"
+#include "Graph.h"
+
+typedef struct IncCentralityRep *IncCentrality;
+
+/**
+ * Computes the centrality measures of the given graph from scratch and
+ * keeps what is needed to update them. All later changes to the graph
+ * must be made through IncCentralityInsertEdge/IncCentralityRemoveEdge.
+ *
+ * The distances from every source take nV^2 entries. If 'compress' is
+ * true, each source's distances are stored in 1, 2 or 4 bytes per entry,
+ * whichever is the narrowest that fits its largest distance.
+ *
+ * Like betweennessCentrality, this and the updates exit with an error if
+ * a shortest path count overflows a double.
+ */
+IncCentrality IncCentralityNew(Graph g, bool compress);
+
+/**
+ * Frees all memory associated with the engine (but not the graph).
+ */
+void IncCentralityFree(IncCentrality ic);
+
+/**
+ * Inserts an edge into the graph exactly like GraphInsertEdge, and
+ * updates the measures by searching again from only the sources whose
+ * shortest paths can use the new edge.
+ */
+void IncCentralityInsertEdge(IncCentrality ic, Vertex src, Vertex dest,
+                             int weight);
+
+/**
+ * Removes an edge from the graph exactly like GraphRemoveEdge, and
+ * updates the measures by searching again from only the sources that had
+ * the edge on one of their shortest paths.
+ */
+void IncCentralityRemoveEdge(IncCentrality ic, Vertex src, Vertex dest);
+
+/**
+ * Returns the current closeness centrality, equal to what
+ * closenessCentrality would return for the graph.
+ */
+NodeValues IncCentralityCloseness(IncCentrality ic);
+
+/**
+ * Returns the current betweenness centrality, equal (up to floating point
+ * rounding) to what betweennessCentrality would return, however many
+ * updates there have been. The sources' kept shares are added up, in
+ * O(V + the number of vertices some source has a dependency on).
+ */
+NodeValues IncCentralityBetweenness(IncCentrality ic);
+
+/**
+ * Returns the current normalised betweenness centrality, as in
+ * betweennessCentralityNormalised.
+ */
+NodeValues IncCentralityBetweennessNormalised(IncCentrality ic);
+
+/**
+ * Returns the number of single source searches run by updates since the
+ * engine was created, one per affected source. A full recompute costs nV
+ * searches.
+ */
+long IncCentralityNumSearches(IncCentrality ic);
+
+#endif
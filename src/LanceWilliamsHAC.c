@@ -4,165 +4,656 @@
 
 #include <assert.h>
 #include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 #include "Graph.h"
 #include "LanceWilliamsHAC.h"
+#include "LanceWilliamsHACExt.h"
+#include "Pool.h"
+#include "Scheduler.h"
+#include "Stats.h"
 
+// Compile with -DHAC_FLOAT_DISTANCES to store distances as floats, which
+// halves the memory of the matrix at the cost of precision
+// INFINITY is the largest finite value rather than math.h's infinity, so
+// that merged pairs can sit above it
+#undef INFINITY
+#ifdef HAC_FLOAT_DISTANCES
+typedef float Distance;
+typedef int32_t DistanceBits;
+#define INFINITY FLT_MAX
+#else
+typedef double Distance;
+typedef int64_t DistanceBits;
 #define INFINITY DBL_MAX
+#endif
 
 #define MERGED -1
 
+// the matrix entry of a pair that includes a merged away cluster; it is
+// above INFINITY, so the closest pair search never picks one
+#define MERGED_DISTANCE HUGE_VAL
+
+// the closest pair search splits the matrix into chunks of this many
+// entries, shared between threads
+#define PAIRS_PER_CHUNK 65536
+
+// the arg-min kernel looks at one SSE register (16 bytes) of distances at
+// a time. Positions within a chunk fit in a lane of the same width, so
+// the masks and positions share a type
+#define LANES (16 / (int)sizeof(Distance))
+typedef Distance DistanceVec __attribute__((vector_size(16)));
+typedef DistanceBits MaskVec __attribute__((vector_size(16)));
+// independent minimums kept by the kernel, so the compare and select of
+// one doesn't wait on the last
+#define ACCUMULATORS 4
+
+// markers for unused and removed NeighbourMap keys
+#define EMPTY   -1
+#define DELETED -2
+
 #define vertex(node) node->vertex
 #define left(node) node->left
 #define right(node) node->right
 
+// the distance between clusters i and j, for i < j
+#define entry(s, i, j) ((s).distance[(s).row[i] + (j)])
+// the same for any order of i and j
+#define between(s, i, j) (*((i) < (j) ? &entry(s, i, j) : &entry(s, j, i)))
+
+// one merge as it was found, with clusters known by their lowest vertex:
+// cluster b is merged into cluster a (a < b)
+typedef struct mergeRecord {
+    int a;
+    int b;
+    Distance distance;
+} MergeRecord;
+
+typedef struct merges {
+    MergeRecord *items; // nV - 1 of them once clustering is done
+    int size;
+} Merges;
+
 // struct that makes everything look nicer
 // :)
+// only the upper triangle of the distance matrix is ever used, so it is
+// stored condensed: the rows i < j are laid end to end in one array, and
+// row[i] is where row i would start if it had entries for j <= i too
+// merge() gathers the rows of the two clusters it joins into 'scratch'
+// so the update is one pass over contiguous memory
+// every way of clustering writes its merges to 'merges', and the
+// Dendrogram or Linkage is built from those at the end
 typedef struct shape {
-    double **distance;
-    Dendrogram *dendro;
+    Distance *distance;
+    size_t *row;
+    bool *merged;       // true once a cluster has been merged into another
+    Merges *merges;
+    int *size;          // the number of vertices in each cluster
+    int *active;        // scratch: the clusters merge() updates
+    Distance *scratch;  // scratch: 4 rows of nV for merge()
     int method;
     Graph graph;
 } Shape;
 
 
+// an edge between two vertices, as a distance for clustering
+typedef struct edge {
+    int u;
+    int v;
+    Distance distance;
+} Edge;
+
+// an edge waiting to be merged, keyed on the clusters it joins
+typedef struct pairEntry {
+    int i;  // the lower cluster index
+    int j;  // the higher cluster index
+    int e;  // the edge
+} PairEntry;
+
+// max heap of PairEntrys, ordered by (i, j)
+typedef struct pairHeap {
+    PairEntry *items;
+    int size;
+} PairHeap;
+
+// the finite distances from one cluster to its neighbours, in an open
+// addressing hash table keyed on the neighbours' slots
+typedef struct neighbourMap {
+    int *keys;         // a slot, EMPTY or DELETED
+    Distance *values;
+    int capacity;      // a power of 2
+    int size;          // live entries
+    int used;          // live and DELETED entries
+} NeighbourMap;
+
+// a pair of clusters that might be merged next, as it was when queued
+typedef struct candidate {
+    Distance distance;
+    int i;             // the lower cluster index
+    int j;             // the higher cluster index
+    int slotP;         // the slots of the two clusters
+    int slotQ;
+} Candidate;
+
+// the closest pair search, shared by the threads running it
+typedef struct scanJob {
+    const Distance *distance;
+    size_t numPairs;
+    int numChunks;
+    Distance *best;       // per chunk: the smallest distance
+    int64_t *bestAt;      // per chunk: where it is, or -1 for none
+} ScanJob;
+
+// min heap of Candidates ordered by closerPair
+typedef struct candidateHeap {
+    Candidate *items;
+    int size;
+    int capacity;
+} CandidateHeap;
+
 // === HELPER FUNCTIONS ===
 static double max(double x, double y);
-static double min(double x, double y);
-static Dendrogram newDNode (int v);
-static Dendrogram newLinkNode (Shape s, int a, int b);
+static Dendrogram newDNode (Pool p, int v);
+static Dendrogram newLinkNode (Pool p, Dendrogram a, Dendrogram b);
+static void denseMerges(Graph g, int method, Merges *merges);
+static void recordMerge(Shape s, int a, int b, Distance distance);
+static int mergeCompare(const void *a, const void *b);
+static int *cutRows(Linkage l, int numKept);
 static double calDistance(double x, double y);
 static int cluster(Shape s);
 static void merge(Shape s, int v1, int v2);
-static void singleLinkage(Shape s, int v1, int v2, int count);
-static void completeLinkage(Shape s, int v1, int v2, int count);
+static bool closestPair(Shape s, int *a, int *b);
+static void scanChunks(void *arg, int lo, int hi);
+static void scanChunk(const Distance *restrict distance, size_t lo, size_t hi,
+                      Distance *best, int64_t *bestAt);
+static void updateRow(int method, int n, const Distance *restrict a,
+                      const Distance *restrict b, const Distance *restrict nk,
+                      Distance *restrict out, Distance ni, Distance nj,
+                      Distance dij);
+static bool reducible(int method);
+static void nearestNeighbourChain(Shape s);
+static int nearestNeighbour(Shape s, int c);
+static double distanceBetween(Shape s, int i, int j);
+static bool closerPair(double d1, int i1, int j1, double d2, int i2, int j2);
+static void forestMerges(Graph g, Merges *merges);
+static void sparseMerges(Graph g, int method, Merges *merges);
+static void joinUnconnected(Shape s, int remaining);
+static int collectEdges(Graph g, Edge *edges);
+static int edgeCompare(const void *a, const void *b);
+static int findRoot(int *parent, int v);
+static void pairPush(PairHeap *h, int i, int j, int e);
+static PairEntry pairPop(PairHeap *h);
+static void mapInit(NeighbourMap *m, int expected);
+static Distance mapGet(NeighbourMap *m, int key);
+static void mapPut(NeighbourMap *m, int key, Distance value);
+static void mapRemove(NeighbourMap *m, int key);
+static int mapFind(NeighbourMap *m, int key);
+static void candidatePush(CandidateHeap *h, Candidate c);
+static Candidate candidatePop(CandidateHeap *h);
+static bool candidateCloser(Candidate c1, Candidate c2);
+static MemoryUsage clusteringMemoryEstimate(Graph g, int method, bool sparse);
+static int mapCapacity(int expected);
 
 /**
  * Generates  a Dendrogram using the Lance-Williams algorithm (discussed
  * in the spec) for the given graph  g  and  the  specified  method  for
- * agglomerative  clustering. The method can be either SINGLE_LINKAGE or
- * COMPLETE_LINKAGE (you only need to implement these two methods).
+ * agglomerative  clustering. The method can be any of the *_LINKAGE
+ * values in LanceWilliamsHAC.h and LanceWilliamsHACExt.h.
  * 
  * The function returns a 'Dendrogram' structure.
  */
 
-// O( nV * nV * (nV - 1))
+// O(E log E) for single linkage, O(nV^2) for other reducible methods,
+// O( nV * nV * (nV - 1)) otherwise
 Dendrogram LanceWilliamsHAC(Graph g, int method){
+    Linkage l = LanceWilliamsLinkage(g, method, false);
+    Dendrogram final = linkageToDendrogram(l);
+    freeLinkage(l);
+    return final;
+}
+
+/**
+ * Generates the same Dendrogram as LanceWilliamsHAC, storing only the
+ * finite distances (one per pair of adjacent vertices) so that time and
+ * memory grow with the number of edges rather than nV^2.
+ */
+// O((nV + E) log E) expected
+Dendrogram LanceWilliamsHACSparse(Graph g, int method) {
+    Linkage l = LanceWilliamsLinkage(g, method, true);
+    Dendrogram final = linkageToDendrogram(l);
+    freeLinkage(l);
+    return final;
+}
+
+/**
+ * Clusters the graph exactly like LanceWilliamsHAC (or, if 'sparse' is
+ * true, LanceWilliamsHACSparse), but returns the merges as one flat
+ * array of rows instead of a tree of nodes.
+ */
+// as for LanceWilliamsHAC
+Linkage LanceWilliamsLinkage(Graph g, int method, bool sparse) {
     if(g == NULL) {
 		fprintf(stderr, "Invalid graph\n");
 	}
-    if (method != SINGLE_LINKAGE && method != COMPLETE_LINKAGE) {
-        fprintf(stderr, "Invalid method: must be SINGLE or COMPLETE linkage\n");
-    } 
-    
-    
+    if (method < SINGLE_LINKAGE || method > MEDIAN_LINKAGE) {
+        fprintf(stderr, "Invalid method: must be one of the *_LINKAGE values\n");
+    }
+
     int nV = GraphNumVertices(g);
-    // distance calulated array
-    double** dist = malloc(nV * sizeof(double*));
-    // dendrogram array
-    Dendrogram *dendro = malloc(nV * sizeof(Dendrogram));
-    // direct distance array, directly from graph
-    int** directDistance = malloc(nV * sizeof(int*));
-    // looping to initalise all the memory for the stuff
-    // O(nV)
-    for (int i = 0; i < nV; i++){
-        dist[i] = calloc(nV, sizeof(double));
-        dendro[i] = newDNode(i);
-        directDistance[i] = calloc(nV, sizeof(int));
+    Merges merges;
+    merges.items = malloc((nV > 1 ? nV - 1 : 1) * sizeof(MergeRecord));
+    merges.size = 0;
+    Linkage l;
+    l.numVertices = nV;
+    l.rows = malloc((nV > 1 ? nV - 1 : 1) * sizeof(LinkageRow));
+    int *id = malloc(nV * sizeof(int));
+    int *size = malloc(nV * sizeof(int));
+    if (merges.items == NULL || l.rows == NULL || id == NULL || size == NULL) {
+        fprintf(stderr, "Couldn't allocate linkage!\n");
+        exit(EXIT_FAILURE);
     }
 
-    // populating the directDistance array
-    // O(nV^2)
+    // single linkage only ever looks at the edges, so it doesn't need
+    // the nV x nV matrices
+    if (sparse) {
+        sparseMerges(g, method, &merges);
+    } else if (method == SINGLE_LINKAGE) {
+        forestMerges(g, &merges);
+    } else {
+        denseMerges(g, method, &merges);
+    }
+
+    // replay the merges, numbering clusters the way SciPy does
+    for (int v = 0; v < nV; v++) {
+        id[v] = v;
+        size[v] = 1;
+    }
+    for (int r = 0; r < merges.size; r++) {
+        MergeRecord m = merges.items[r];
+        l.rows[r].left = id[m.a];
+        l.rows[r].right = id[m.b];
+        l.rows[r].distance = m.distance == INFINITY ? HUGE_VAL : m.distance;
+        l.rows[r].size = size[m.a] + size[m.b];
+        id[m.a] = nV + r;
+        size[m.a] = l.rows[r].size;
+    }
+    free(merges.items);
+    free(id);
+    free(size);
+    return l;
+}
+
+/**
+ * Cuts the hierarchy into k clusters and returns a label for each vertex.
+ */
+// O(nV)
+int *linkageCutClusters(Linkage l, int k) {
+    assert(k >= 1 && k <= (l.numVertices > 0 ? l.numVertices : 1));
+    return cutRows(l, l.numVertices - k);
+}
+
+/**
+ * Cuts the hierarchy at the given distance and returns a label for each
+ * vertex.
+ */
+// O(nV)
+int *linkageCutDistance(Linkage l, double threshold) {
+    int numKept = 0;
+    while (numKept < l.numVertices - 1 &&
+           l.rows[numKept].distance <= threshold) {
+        numKept++;
+    }
+    return cutRows(l, numKept);
+}
+
+/**
+ * Builds the Dendrogram that matches the given Linkage.
+ */
+// O(nV)
+// every node comes from one pool, owned by the root, which
+// freeDendrogram frees whole
+Dendrogram linkageToDendrogram(Linkage l) {
+    int nV = l.numVertices;
+    if (nV == 0) {
+        return NULL;
+    }
+    Dendrogram *node = malloc((2 * (size_t)nV - 1) * sizeof(Dendrogram));
+    if (node == NULL) {
+        fprintf(stderr, "Couldn't allocate dendrogram!\n");
+        exit(EXIT_FAILURE);
+    }
+    Pool pool = PoolNew(sizeof(DNode));
+    for (int v = 0; v < nV; v++) {
+        node[v] = newDNode(pool, v);
+    }
+    for (int r = 0; r < nV - 1; r++) {
+        node[nV + r] = newLinkNode(pool, node[l.rows[r].left],
+                                   node[l.rows[r].right]);
+    }
+    Dendrogram final = node[2 * nV - 2];
+    PoolSetOwner(pool, final);
+    free(node);
+    return final;
+}
+
+/**
+ * Frees all memory associated with the given Linkage structure.
+ */
+void freeLinkage(Linkage l) {
+    free(l.rows);
+}
+
+// O(nV^2) for complete linkage, which follows the nearest neighbour
+// chain, and O(nV^3) for the other methods, which scan the matrix for
+// every merge
+// clusters g through the distance matrix, for every method but single
+// linkage, which LanceWilliamsHAC takes from the spanning forest instead
+// (forestMerges)
+static void denseMerges(Graph g, int method, Merges *merges) {
+    int nV = GraphNumVertices(g);
+    // condensed distance array, nV * (nV - 1) / 2 entries
+    size_t numPairs = (size_t)nV * (nV - 1) / 2;
+    Distance *dist = malloc((numPairs > 0 ? numPairs : 1) * sizeof(Distance));
+    size_t *row = malloc(nV * sizeof(size_t));
+    bool *merged = calloc(nV, sizeof(bool));
+    int numEdges = 0;
     for (int i = 0; i < nV; i++){
-        AdjList out = GraphOutIncident(g,i);
-        AdjList head;
-        for(head = out; head != NULL; head = head->next) {
-            directDistance[i][head->v] = head->weight;
+        for (AdjList out = GraphOutIncident(g, i); out != NULL; out = out->next) {
+            numEdges++;
         }
     }
-   
+    Edge *edges = malloc((numEdges > 0 ? numEdges : 1) * sizeof(Edge));
+    int *size = malloc(nV * sizeof(int));
+    int *active = malloc(nV * sizeof(int));
+    Distance *scratch = malloc(4 * (size_t)nV * sizeof(Distance));
+    if (dist == NULL || row == NULL || merged == NULL || edges == NULL ||
+        size == NULL || active == NULL || scratch == NULL) {
+        fprintf(stderr, "Couldn't allocate distance matrix!\n");
+        exit(EXIT_FAILURE);
+    }
+    // O(nV)
+    for (int i = 0; i < nV; i++){
+        // row i holds j = i + 1 ... nV - 1, after the rows above it
+        row[i] = (size_t)i * nV - (size_t)i * (i + 1) / 2 - (i + 1);
+        size[i] = 1;
+    }
    
     // O(nV^2)
-    for (int i = 0; i < nV; i++){
-    // populating dist matrix with the calulated distance
-        for (int j = i + 1; j < nV; j++){
-            if(directDistance[i][j] == 0 && directDistance[j][i] == 0){
-            // if no edges exist
-                dist[i][j] = INFINITY;
-            } else{
-                double a = (double)directDistance[j][i];
-                double b = (double)directDistance[i][j];
-                dist[i][j] = calDistance(a, b);
-            }
-        }
+    // populating dist with the calulated distance, INFINITY if no edges exist
+    for (size_t k = 0; k < numPairs; k++) {
+        dist[k] = INFINITY;
     }
+    numEdges = collectEdges(g, edges);
+    for (int e = 0; e < numEdges; e++) {
+        dist[row[edges[e].u] + edges[e].v] = edges[e].distance;
+    }
+    free(edges);
     Shape s;
     s.distance = dist;
-    s.dendro = dendro;
+    s.row = row;
+    s.merged = merged;
+    s.merges = merges;
+    s.size = size;
+    s.active = active;
+    s.scratch = scratch;
     s.graph = g;
     s.method = method;
 
 
-    int index = 0;
-    
-    int check = cluster(s);
+    if (reducible(method)) {
+        // O(nV^2)
+        // the chain finds merges out of order, but with single or
+        // complete linkage a merge is never further apart than a later
+        // merge involving its cluster, so sorting by distance puts them
+        // in cluster()'s order, except among equally distant merges.
+        // Of those cluster() takes the highest pair first (closerPair),
+        // and a merge only ever leaves lower pairs at the same distance,
+        // so ties are sorted by closerPair as well
+        nearestNeighbourChain(s);
+        qsort(merges->items, merges->size, sizeof(MergeRecord), mergeCompare);
+    } else {
+        int check = cluster(s);
     
-    // finding all remaining clusters
-    // O(nV^2 * nV - 1)
-    while(check != MERGED){
+        // finding all remaining clusters
+        // O(nV^2 * nV - 1)
+        while(check != MERGED){
+            check = cluster(s);
+        }
+    }
+    free(merged);
+    free(dist);
+    free(row);
+    free(size);
+    free(active);
+    free(scratch);
+}
 
-        index = check;
-        check = cluster(s);
+// O((nV + E) log E) expected
+// each cluster keeps its finite distances in a hash map, and every pair
+// that could be merged waits in one heap ordered the way cluster() picks
+// pairs. Merging two clusters moves the smaller map into the larger one,
+// so only the smaller cluster's neighbours need the Lance-Williams update
+// (a neighbour of only the larger one is missing from the smaller one,
+// and a missing distance never changes the linkage)
+// clusters are known by their lowest vertex, as in the matrix, but their
+// maps live in 'slots' that don't change when a cluster is renamed by a
+// merge. A queued pair whose distance or names have changed since it was
+// queued is stale: if its distance changed a fresh entry was queued too,
+// so it is dropped, and if only the names changed it can only have
+// become less preferred, so it is queued again under its current names
+static void sparseMerges(Graph g, int method, Merges *merges) {
+    int nV = GraphNumVertices(g);
+    int numEdges = 0;
+    for (int v = 0; v < nV; v++) {
+        for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+            numEdges++;
+        }
     }
-    Dendrogram final = dendro[index];
-    // O(nV)
-    for(int i = 0; i < nV; i++) {
-        free(dist[i]);
-        free(directDistance[i]);
+    Shape s;
+    s.distance = NULL;
+    s.row = NULL;
+    s.active = NULL;
+    s.scratch = NULL;
+    s.merged = calloc(nV > 0 ? nV : 1, sizeof(bool));
+    s.merges = merges;
+    s.size = malloc(nV * sizeof(int));   // per slot
+    s.method = method;
+    s.graph = g;
+    Edge *edges = malloc((numEdges > 0 ? numEdges : 1) * sizeof(Edge));
+    NeighbourMap *maps = malloc(nV * sizeof(NeighbourMap));
+    int *name = malloc(nV * sizeof(int));   // the cluster index of each slot
+    int *degree = calloc(nV, sizeof(int));
+    CandidateHeap heap;
+    heap.capacity = numEdges > 0 ? numEdges : 1;
+    heap.items = malloc(heap.capacity * sizeof(Candidate));
+    heap.size = 0;
+    if (s.merged == NULL || s.size == NULL || edges == NULL || maps == NULL ||
+        name == NULL || degree == NULL || heap.items == NULL) {
+        fprintf(stderr, "Couldn't allocate sparse clustering!\n");
+        exit(EXIT_FAILURE);
     }
-    free(dendro);
-    free(dist);
-    free(directDistance);
 
-    
+    numEdges = collectEdges(g, edges);
+    for (int e = 0; e < numEdges; e++) {
+        degree[edges[e].u]++;
+        degree[edges[e].v]++;
+    }
+    for (int v = 0; v < nV; v++) {
+        s.size[v] = 1;
+        name[v] = v;
+        mapInit(&maps[v], degree[v]);
+    }
+    free(degree);
+    for (int e = 0; e < numEdges; e++) {
+        Edge edge = edges[e];
+        mapPut(&maps[edge.u], edge.v, edge.distance);
+        mapPut(&maps[edge.v], edge.u, edge.distance);
+        candidatePush(&heap, (Candidate) {edge.distance, edge.u, edge.v,
+                                          edge.u, edge.v});
+    }
+    free(edges);
 
-    return final;
-    // return the last head node 
-}
+    int remaining = nV;
+    while (heap.size > 0) {
+        Candidate c = candidatePop(&heap);
+        // a merged away slot has an empty map, so this also drops pairs
+        // that include one
+        if (mapGet(&maps[c.slotP], c.slotQ) != c.distance ||
+            maps[c.slotP].size == 0) {
+            continue;
+        }
+        int i = name[c.slotP] < name[c.slotQ] ? name[c.slotP] : name[c.slotQ];
+        int j = name[c.slotP] < name[c.slotQ] ? name[c.slotQ] : name[c.slotP];
+        if (i != c.i || j != c.j) {
+            c.i = i;
+            c.j = j;
+            candidatePush(&heap, c);
+            continue;
+        }
+
+        int big = c.slotP;
+        int small = c.slotQ;
+        if (maps[small].size > maps[big].size) {
+            big = c.slotQ;
+            small = c.slotP;
+        }
+        // updateRow needs the distances in the order the matrix has them
+        int slotI = name[c.slotP] == i ? c.slotP : c.slotQ;
+        Distance ni = s.size[slotI];
+        Distance nj = s.size[slotI == c.slotP ? c.slotQ : c.slotP];
+        mapRemove(&maps[big], small);
+        name[big] = i;
+        s.size[big] = s.size[c.slotP] + s.size[c.slotQ];
+        for (int e = 0; e < maps[small].capacity; e++) {
+            int k = maps[small].keys[e];
+            if (k < 0 || k == big) {
+                continue;
+            }
+            Distance dBig = mapGet(&maps[big], k);
+            Distance dSmall = maps[small].values[e];
+            Distance a = small == slotI ? dSmall : dBig;
+            Distance b = small == slotI ? dBig : dSmall;
+            Distance nk = s.size[k];
+            Distance d;
+            updateRow(method, 1, &a, &b, &nk, &d, ni, nj, c.distance);
+            mapPut(&maps[big], k, d);
+            mapRemove(&maps[k], small);
+            mapPut(&maps[k], big, d);
+            candidatePush(&heap, (Candidate) {d, i < name[k] ? i : name[k],
+                                              i < name[k] ? name[k] : i, big, k});
+        }
+        free(maps[small].keys);
+        free(maps[small].values);
+        mapInit(&maps[small], 0);
 
+        recordMerge(s, i, j, c.distance);
+        remaining--;
+    }
+
+    joinUnconnected(s, remaining);
+    for (int v = 0; v < nV; v++) {
+        free(maps[v].keys);
+        free(maps[v].values);
+    }
+    free(maps);
+    free(name);
+    free(heap.items);
+    free(s.merged);
+    free(s.size);
+}
 
 /**
  * Frees all memory associated with the given Dendrogram structure.
  */
-// O(1)
+// O(chunks) for a whole dendrogram, O(size of d) for a subtree
+// the nodes all share the pool made by linkageToDendrogram, so the whole
+// tree goes at once without being walked. A subtree's nodes are given
+// back one by one, and the pool goes with the last of them. Single
+// linkage trees can be as deep as they are wide, so rather than keeping
+// a stack the walk rotates each left child up until the node on top has
+// none, then gives that node back and carries on down its right
 void freeDendrogram(Dendrogram d) {
-    if(d == NULL) return;
-    freeDendrogram(left(d));
-    freeDendrogram(right(d));
-    free(d);
+    if (d == NULL) {
+        return;
+    }
+    Pool pool = PoolOf(d);
+    if (PoolOwner(pool) != d) {
+        while (d != NULL) {
+            if (left(d) != NULL) {
+                Dendrogram l = left(d);
+                left(d) = right(l);
+                right(l) = d;
+                d = l;
+            } else {
+                Dendrogram next = right(d);
+                PoolRelease(pool, d);
+                d = next;
+            }
+        }
+        if (PoolNumLive(pool) > 0) {
+            return;
+        }
+    }
+    PoolFree(pool);
 }
 
-// ========================
-// === HELPER FUNCTIONS ===
-// ========================
+/**
+ * Returns the memory held by the given Dendrogram.
+ */
+// O(chunks)
+MemoryUsage dendrogramMemoryUsage(Dendrogram d) {
+    MemoryUsage m = {0};
+    if (d != NULL) {
+        m = PoolMemoryUsage(PoolOf(d), MEMORY_TREE_NODES);
+    }
+    return m;
+}
 
-// O(1)
-// returns min of two numbers
-static double min(double x,double y) {
-    if(x == INFINITY && y == INFINITY) {
-        return INFINITY;
-    } else if(x == INFINITY)  {
-        return y;
-    } else if (y == INFINITY) {
-        return x;
+/**
+ * Returns the memory held by the given Linkage.
+ */
+MemoryUsage linkageMemoryUsage(Linkage l) {
+    int nV = l.numVertices;
+    MemoryUsage m = {0};
+    MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1,
+              (nV > 1 ? nV - 1 : 1) * sizeof(LinkageRow));
+    return m;
+}
+
+/**
+ * Returns the most memory LanceWilliamsHAC or LanceWilliamsHACSparse
+ * holds at once.
+ */
+// O(nV + E)
+// the peak is either while clustering, or while linkageToDendrogram
+// builds the tree from the rows
+MemoryUsage LanceWilliamsMemoryEstimate(Graph g, int method, bool sparse) {
+    int nV = GraphNumVertices(g);
+    MemoryUsage clustering = clusteringMemoryEstimate(g, method, sparse);
+
+    Linkage l = {nV, NULL};
+    MemoryUsage building = linkageMemoryUsage(l);
+    if (nV > 0) {
+        MemoryAdd(&building, MEMORY_VERTEX_ARRAYS, 1,
+                  (2 * (size_t)nV - 1) * sizeof(Dendrogram));
+        MemoryCombine(&building, PoolMemoryEstimate(sizeof(DNode),
+                                                    2 * (size_t)nV - 1,
+                                                    MEMORY_TREE_NODES));
     }
-    return (x > y ? y : x);
+    return clustering.total > building.total ? clustering : building;
 }
 
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
 // O(1)
 // returns max of two nums
 static double max(double x, double y) {
@@ -185,12 +676,12 @@ static double calDistance(double x, double y) {
 
 // O(1)
 // new linking node
-static Dendrogram newLinkNode(Shape s, int a, int b) {
-    Dendrogram new = malloc(sizeof(DNode));
+static Dendrogram newLinkNode(Pool p, Dendrogram a, Dendrogram b) {
+    Dendrogram new = PoolAlloc(p);
     
     vertex(new) = -1;
-    left(new) = s.dendro[a];
-    right(new) = s.dendro[b];
+    left(new) = a;
+    right(new) = b;
     
     return new;
 }
@@ -198,8 +689,8 @@ static Dendrogram newLinkNode(Shape s, int a, int b) {
 // O(1)
 // new normal node
 // used in initalisation
-static Dendrogram newDNode(int v) {
-    Dendrogram new = malloc(sizeof(DNode));
+static Dendrogram newDNode(Pool p, int v) {
+    Dendrogram new = PoolAlloc(p);
     vertex(new) = v;
     left(new) = NULL;
     right(new) = NULL;
@@ -208,29 +699,14 @@ static Dendrogram newDNode(int v) {
 }
 
 
-// O(nV^2)
+// O(nV^2), split across cores
 // function that clusters nodes
 static int cluster(Shape s){
-    int nV = GraphNumVertices(s.graph);
-    double minimum  = INFINITY;
     int a = -1;
     int b = -1;
 
-    // finding a shortest path
-    for (int i = 0; i < nV; i++){
-        for (int j = i + 1; j < nV; j++){
-            if(s.distance[i][j] != 0){
-                if(s.distance[i][j] <= minimum){
-                minimum = s.distance[i][j];
-                a = i;
-                b = j;
-            }
-            } 
-        }
-    }
-
     // merging is complete
-    if(a == MERGED && b == MERGED){
+    if(!closestPair(s, &a, &b)){
         return MERGED;
     } else{
         merge(s, a, b);
@@ -238,63 +714,824 @@ static int cluster(Shape s){
     return a;
 }
 
+// O(nV^2 / (cores * LANES))
+// finds the pair with the smallest distance, taking the last one in row
+// by row order if there is a tie (as a <= scan would), and returns false
+// if every pair is merged
+// rows are laid end to end in the matrix, so row by row order is just
+// the order of the array: each chunk of it finds its own last minimum,
+// and the chunks are compared in order
+static bool closestPair(Shape s, int *a, int *b) {
+    int nV = GraphNumVertices(s.graph);
+    size_t numPairs = (size_t)nV * (nV - 1) / 2;
+    if (nV < 2) {
+        return false;
+    }
+    STATS_TIMER(start);
+    STATS_ADD(STATS_HAC_SCANS, 1);
+    STATS_ADD(STATS_HAC_PAIRS, (long)numPairs);
+
+    ScanJob job;
+    job.distance = s.distance;
+    job.numPairs = numPairs;
+    job.numChunks = (numPairs + PAIRS_PER_CHUNK - 1) / PAIRS_PER_CHUNK;
+    job.best = malloc(job.numChunks * sizeof(Distance));
+    job.bestAt = malloc(job.numChunks * sizeof(int64_t));
+    if (job.best == NULL || job.bestAt == NULL) {
+        fprintf(stderr, "Couldn't allocate closest pair search!\n");
+        exit(EXIT_FAILURE);
+    }
+    SchedulerFor(job.numChunks, 1, scanChunks, &job);
+
+    Distance minimum = INFINITY;
+    int64_t at = -1;
+    for (int c = 0; c < job.numChunks; c++) {
+        if (job.bestAt[c] != -1 && job.best[c] <= minimum) {
+            minimum = job.best[c];
+            at = job.bestAt[c];
+        }
+    }
+    free(job.best);
+    free(job.bestAt);
+    STATS_TIMER_STOP(start, STATS_HAC_SEARCH);
+    if (at == -1) {
+        return false;
+    }
+
+    // row i starts at row[i] + i + 1
+    int lo = 0;
+    int hi = nV - 2;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (s.row[mid] + mid + 1 <= (size_t)at) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    *a = lo;
+    *b = at - s.row[lo];
+    return true;
+}
+
+// searches chunks lo to hi - 1, each on its own so the result doesn't
+// depend on how they were shared out
+static void scanChunks(void *arg, int lo, int hi) {
+    ScanJob *job = arg;
+    for (int c = lo; c < hi; c++) {
+        size_t first = (size_t)c * PAIRS_PER_CHUNK;
+        size_t last = first + PAIRS_PER_CHUNK < job->numPairs ?
+                      first + PAIRS_PER_CHUNK : job->numPairs;
+        scanChunk(job->distance, first, last, &job->best[c], &job->bestAt[c]);
+    }
+}
+
+// O(hi - lo)
+// the arg-min kernel: each lane of each accumulator keeps the last
+// smallest distance it has seen and where it was, using masks instead of
+// branches, so ACCUMULATORS vectors of entries are handled per step.
+// Merged entries (above INFINITY) are never taken. The lanes are then
+// combined, preferring the later entry on ties, and the leftover entries
+// are taken the same way
+static void scanChunk(const Distance *restrict distance, size_t lo, size_t hi,
+                      Distance *best, int64_t *bestAt) {
+    DistanceVec bestVec[ACCUMULATORS];
+    MaskVec bestAtVec[ACCUMULATORS];   // positions from lo
+    MaskVec atVec[ACCUMULATORS];
+    for (int u = 0; u < ACCUMULATORS; u++) {
+        for (int l = 0; l < LANES; l++) {
+            bestVec[u][l] = INFINITY;
+            bestAtVec[u][l] = -1;
+            atVec[u][l] = u * LANES + l;
+        }
+    }
+
+    size_t k = lo;
+    for (; k + ACCUMULATORS * LANES <= hi; k += ACCUMULATORS * LANES) {
+        for (int u = 0; u < ACCUMULATORS; u++) {
+            DistanceVec d;
+            memcpy(&d, &distance[k + u * LANES], sizeof(d));
+            MaskVec take = d <= bestVec[u];
+            bestVec[u] = (DistanceVec)(((MaskVec)d & take) |
+                                       ((MaskVec)bestVec[u] & ~take));
+            bestAtVec[u] = (atVec[u] & take) | (bestAtVec[u] & ~take);
+            atVec[u] += ACCUMULATORS * LANES;
+        }
+    }
+
+    Distance minimum = INFINITY;
+    int64_t at = -1;
+    for (int u = 0; u < ACCUMULATORS; u++) {
+        for (int l = 0; l < LANES; l++) {
+            int64_t laneAt = bestAtVec[u][l] == -1 ? -1 :
+                             (int64_t)(lo + bestAtVec[u][l]);
+            if (laneAt != -1 && (bestVec[u][l] < minimum ||
+                                 (bestVec[u][l] == minimum && laneAt > at))) {
+                minimum = bestVec[u][l];
+                at = laneAt;
+            }
+        }
+    }
+    for (; k < hi; k++) {
+        if (distance[k] <= minimum) {
+            minimum = distance[k];
+            at = k;
+        }
+    }
+    *best = minimum;
+    *bestAt = at;
+}
+
+// O(1)
+// a linkage is reducible if merging two clusters never makes the new
+// cluster closer to a third one than the closer of the two was:
+// d(i + j, k) >= min(d(i, k), d(j, k))
+// single linkage takes the min and complete linkage the max (ignoring
+// missing edges), so both are
+// average, weighted and Ward linkage are reducible too, but only single
+// and complete linkage give the same distances whatever order the merges
+// happen in once missing edges are skipped (the mean of a missing and a
+// present distance is just the present one), and the chain merges in a
+// different order to cluster(). Centroid and median linkage aren't
+// reducible at all
+static bool reducible(int method) {
+    return method == SINGLE_LINKAGE || method == COMPLETE_LINKAGE;
+}
+
+// O(nV^2)
+// builds the same dendrogram as calling cluster() until everything is
+// merged, without scanning the whole matrix for every merge
+// follows a chain of nearest neighbours (each cluster's nearest neighbour
+// is pushed on top of it) until the top two are each other's nearest
+// neighbour, and merges them. For a reducible linkage that merge doesn't
+// change anyone else's nearest neighbour, so the rest of the chain stays
+// valid, and the result is the same hierarchy cluster() finds
+// closerPair breaks ties the way the <= scan in cluster() does, so the
+// dendrograms match exactly even when distances are equal
+static void nearestNeighbourChain(Shape s) {
+    int nV = GraphNumVertices(s.graph);
+    int *chain = malloc(nV * sizeof(int));
+    if (chain == NULL) {
+        fprintf(stderr, "Couldn't allocate chain!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int chainSize = 0;
+    int next = 0;   // no active cluster is below this index when the chain is empty
+    for (int remaining = nV; remaining > 1; ) {
+        if (chainSize == 0) {
+            while (s.merged[next]) {
+                next++;
+            }
+            chain[chainSize++] = next;
+        }
+
+        int top = chain[chainSize - 1];
+        int nearest = nearestNeighbour(s, top);
+        if (chainSize > 1 && nearest == chain[chainSize - 2]) {
+            // reciprocal nearest neighbours
+            chainSize -= 2;
+            int a = top < nearest ? top : nearest;
+            int b = top < nearest ? nearest : top;
+            merge(s, a, b);
+            remaining--;
+        } else {
+            chain[chainSize++] = nearest;
+        }
+    }
+    free(chain);
+}
+
+// O(nV)
+// finds the cluster closest to cluster c, with ties broken by closerPair
+static int nearestNeighbour(Shape s, int c) {
+    int nV = GraphNumVertices(s.graph);
+    int best = -1;
+    double bestDist = INFINITY;
+    for (int k = 0; k < nV; k++) {
+        if (k == c || s.merged[k]) {
+            continue;
+        }
+        double d = distanceBetween(s, c, k);
+        int i = c < k ? c : k;
+        int j = c < k ? k : c;
+        int bestI = c < best ? c : best;
+        int bestJ = c < best ? best : c;
+        if (best == -1 || closerPair(d, i, j, bestDist, bestI, bestJ)) {
+            best = k;
+            bestDist = d;
+        }
+    }
+    return best;
+}
+
+// O(1)
+// distance between two active clusters, from the upper triangle
+static double distanceBetween(Shape s, int i, int j) {
+    return i < j ? entry(s, i, j) : entry(s, j, i);
+}
+
+// O(1)
+// true if pair (i1, j1) would be picked over pair (i2, j2) by cluster(),
+// which takes the smallest distance and, as it uses <= while scanning row
+// by row, the last such pair in that order
+static bool closerPair(double d1, int i1, int j1, double d2, int i2, int j2) {
+    if (d1 != d2) {
+        return d1 < d2;
+    }
+    return i1 > i2 || (i1 == i2 && j1 > j2);
+}
+
 // O(nV)
 // this function merges the nodes and node clusters into bigger clusters
 // updating the distance between new nodes
+// the distances from v1 and v2 to every cluster still active are
+// gathered into contiguous rows, combined by updateRow in one pass and
+// scattered back into v1's entries; v2's entries become MERGED_DISTANCE
 static void merge(Shape s, int v1, int v2) {
     int nV = GraphNumVertices(s.graph);
+    Distance *a = s.scratch;
+    Distance *b = s.scratch + nV;
+    Distance *nk = s.scratch + 2 * nV;
+    Distance *out = s.scratch + 3 * nV;
+    STATS_TIMER(start);
+    recordMerge(s, v1, v2, entry(s, v1, v2));
     
-    // new link node
-    Dendrogram new = newLinkNode(s, v1, v2);
-    //update the array and inserting new cluster node
-    s.dendro[v1] = new;
-    s.dendro[v2] = NULL;
+    int n = 0;
+    for (int k = 0; k < nV; k++) {
+        if (k == v1 || k == v2 || s.merged[k]) {
+            continue;
+        }
+        s.active[n] = k;
+        a[n] = between(s, v1, k);
+        b[n] = between(s, v2, k);
+        nk[n] = s.size[k];
+        n++;
+    }
+    updateRow(s.method, n, a, b, nk, out, s.size[v1], s.size[v2],
+              entry(s, v1, v2));
+    STATS_ADD(STATS_HAC_MERGES, 1);
+    STATS_ADD(STATS_HAC_UPDATES, n);
+    for (int e = 0; e < n; e++) {
+        int k = s.active[e];
+        between(s, v1, k) = out[e];
+        between(s, v2, k) = MERGED_DISTANCE;
+    }
+    entry(s, v1, v2) = MERGED_DISTANCE;
+    s.size[v1] = s.size[v1] + s.size[v2];
+    STATS_TIMER_STOP(start, STATS_HAC_MERGE);
+}
 
-    //update the matrix
-    for(int i = 0; i < nV; i++) {
-        // since the array is a ladder so there are several conditions for q
-        if(i == v1){
-            // renew dist[A][B] to be set as found
-            s.distance[i][v2] = 0;
+// O(n)
+// the Lance-Williams update: out[k] is the distance from cluster k to
+// the union of clusters i and j, where a[k] and b[k] are its distances to
+// i and j, nk[k] its size, ni and nj the sizes of i and j and dij the
+// distance between them
+// the coefficients are those of the general form
+// d = alphaI * a + alphaJ * b + beta * dij + gamma * |a - b|
+// with single and complete linkage written as min and max so they stay
+// exact. A missing (INFINITY) distance to one half counts for nothing,
+// so the other half's distance is kept
+// the loops have no branches or dependencies between iterations, so GCC
+// can turn them into vector code, but only with -O3 (or -O2
+// -ftree-vectorize -fvect-cost-model=dynamic). The default -O2 build
+// leaves them scalar with GCC 12 and earlier
+static void updateRow(int method, int n, const Distance *restrict a,
+                      const Distance *restrict b, const Distance *restrict nk,
+                      Distance *restrict out, Distance ni, Distance nj,
+                      Distance dij) {
+    Distance alphaI = ni / (ni + nj);
+    Distance alphaJ = nj / (ni + nj);
+    Distance half = 0.5;
+    switch (method) {
+    case SINGLE_LINKAGE:
+        for (int k = 0; k < n; k++) {
+            out[k] = a[k] > b[k] ? b[k] : a[k];
+        }
+        break;
+    case COMPLETE_LINKAGE:
+        for (int k = 0; k < n; k++) {
+            out[k] = a[k] > b[k] ? a[k] : b[k];
+        }
+        break;
+    case AVERAGE_LINKAGE:
+        for (int k = 0; k < n; k++) {
+            out[k] = alphaI * a[k] + alphaJ * b[k];
         }
-        if (s.method == SINGLE_LINKAGE) {
-            singleLinkage(s, v1, v2, i);
-        } else if(s.method == COMPLETE_LINKAGE) {
-            completeLinkage(s, v1, v2, i);
+        break;
+    case WEIGHTED_LINKAGE:
+        for (int k = 0; k < n; k++) {
+            out[k] = half * a[k] + half * b[k];
         }
-        
-        if(i < v1) {
-            s.distance[i][v2] = 0;
-        } else if( i > v1 && i < v2) {
-            s.distance[i][v2] = 0;
-        } else if (i > v2) {
-            s.distance[v2][i] = 0;
+        break;
+    case WARD_LINKAGE:
+        for (int k = 0; k < n; k++) {
+            out[k] = ((ni + nk[k]) * a[k] + (nj + nk[k]) * b[k] - nk[k] * dij) /
+                     (ni + nj + nk[k]);
         }
+        break;
+    case CENTROID_LINKAGE: {
+        Distance beta = -alphaI * alphaJ * dij;
+        for (int k = 0; k < n; k++) {
+            out[k] = alphaI * a[k] + alphaJ * b[k] + beta;
+        }
+        break;
+    }
+    case MEDIAN_LINKAGE: {
+        Distance beta = -half * half * dij;
+        for (int k = 0; k < n; k++) {
+            out[k] = half * a[k] + half * b[k] + beta;
+        }
+        break;
+    }
+    }
+    for (int k = 0; k < n; k++) {
+        Distance ab = a[k] == INFINITY ? b[k] : out[k];
+        out[k] = b[k] == INFINITY ? a[k] : ab;
+    }
+}
+
+// O(E log E) time, O(nV + E) memory
+// single linkage merges the two clusters joined by the shortest remaining
+// edge, which is Kruskal's algorithm for a minimum spanning forest
+// edges are taken shortest first, with union find tracking the clusters.
+// Each cluster is known by its lowest vertex, like the rows of the matrix
+// in cluster(). For a run of equally short edges cluster() picks the
+// pair with the highest (lower index, higher index), so those edges wait
+// in a heap on that pair; a merge can only lower an edge's pair, so one
+// that comes out stale is pushed back with its new pair
+// once the edges run out the remaining clusters are all INFINITY apart,
+// and cluster() then always joins the two with the highest indices
+static void forestMerges(Graph g, Merges *merges) {
+    int nV = GraphNumVertices(g);
+    Shape s;
+    s.distance = NULL;
+    s.row = NULL;
+    s.active = NULL;
+    s.scratch = NULL;
+    s.size = NULL;
+    s.merged = calloc(nV, sizeof(bool));
+    s.merges = merges;
+    s.method = SINGLE_LINKAGE;
+    s.graph = g;
+    int *parent = malloc(nV * sizeof(int));
+    int *size = malloc(nV * sizeof(int));
+    int *lowest = malloc(nV * sizeof(int));   // lowest vertex of each root
+    int numEdges = 0;
+    for (int v = 0; v < nV; v++) {
+        for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+            numEdges++;
+        }
+    }
+    Edge *edges = malloc((numEdges > 0 ? numEdges : 1) * sizeof(Edge));
+    PairHeap heap;
+    heap.items = malloc((numEdges > 0 ? numEdges : 1) * sizeof(PairEntry));
+    heap.size = 0;
+    if (s.merged == NULL || parent == NULL || size == NULL ||
+        lowest == NULL || edges == NULL || heap.items == NULL) {
+        fprintf(stderr, "Couldn't allocate spanning forest!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int v = 0; v < nV; v++) {
+        parent[v] = v;
+        size[v] = 1;
+        lowest[v] = v;
+    }
+
+    numEdges = collectEdges(g, edges);
+    qsort(edges, numEdges, sizeof(Edge), edgeCompare);
+
+    int remaining = nV;
+    for (int first = 0; first < numEdges; ) {
+        int last = first;
+        while (last < numEdges &&
+               edges[last].distance == edges[first].distance) {
+            pairPush(&heap, edges[last].u, edges[last].v, last);
+            last++;
+        }
+
+        while (heap.size > 0) {
+            PairEntry top = pairPop(&heap);
+            int ru = findRoot(parent, edges[top.e].u);
+            int rv = findRoot(parent, edges[top.e].v);
+            if (ru == rv) {
+                continue;
+            }
+            int a = lowest[ru] < lowest[rv] ? lowest[ru] : lowest[rv];
+            int b = lowest[ru] < lowest[rv] ? lowest[rv] : lowest[ru];
+            if (a != top.i || b != top.j) {
+                pairPush(&heap, a, b, top.e);
+                continue;
+            }
+
+            recordMerge(s, a, b, edges[top.e].distance);
+            if (size[ru] < size[rv]) {
+                int tmp = ru;
+                ru = rv;
+                rv = tmp;
+            }
+            parent[rv] = ru;
+            size[ru] += size[rv];
+            lowest[ru] = a;
+            remaining--;
+        }
+        first = last;
+    }
+
+    joinUnconnected(s, remaining);
+    free(s.merged);
+    free(parent);
+    free(size);
+    free(lowest);
+    free(edges);
+    free(heap.items);
+}
+
+// O(nV)
+// joins the clusters left once no finite distances remain; every pair is
+// then INFINITY apart, so cluster() would always pick the two with the
+// highest indices
+static void joinUnconnected(Shape s, int remaining) {
+    int nV = GraphNumVertices(s.graph);
+    int b = -1;
+    for (int v = nV - 1; v >= 0 && remaining > 1; v--) {
+        if (s.merged[v]) {
+            continue;
+        }
+        if (b != -1) {
+            recordMerge(s, v, b, INFINITY);
+            remaining--;
+        }
+        b = v;
     }
 }
 
 // O(1)
-// updating distance for the new cluster
-// according to using a single linkage method
-static void singleLinkage(Shape s, int v1, int v2, int count) {
-        if(count < v1) {
-            s.distance[count][v1] = min(s.distance[count][v1],s.distance[count][v2]);
-        } else if(count > v1 && count < v2) {
-            s.distance[v1][count] = min(s.distance[v1][count],s.distance[count][v2]);
-        } else if (count > v2) {
-            s.distance[v1][count] = min(s.distance[v1][count],s.distance[v2][count]);
+// notes that cluster b (the higher index) was merged into cluster a
+static void recordMerge(Shape s, int a, int b, Distance distance) {
+    MergeRecord *m = &s.merges->items[s.merges->size];
+    m->a = a;
+    m->b = b;
+    m->distance = distance;
+    s.merges->size++;
+    s.merged[b] = true;
+}
+
+// orders merges the way cluster() would pick them: by distance, then
+// the highest pair first (no two merges join the same pair)
+static int mergeCompare(const void *a, const void *b) {
+    const MergeRecord *m1 = a;
+    const MergeRecord *m2 = b;
+    if (closerPair(m1->distance, m1->a, m1->b, m2->distance, m2->a, m2->b)) {
+        return -1;
+    }
+    return closerPair(m2->distance, m2->a, m2->b, m1->distance, m1->a, m1->b);
+}
+
+// O(nV)
+// labels the clusters left after the first numKept merges
+// each merge's cluster passes its root on to the two it was made from,
+// latest first, so every vertex ends up knowing its root
+static int *cutRows(Linkage l, int numKept) {
+    int nV = l.numVertices;
+    int *root = malloc((nV > 0 ? 2 * (size_t)nV - 1 : 1) * sizeof(int));
+    int *label = malloc((nV > 0 ? 2 * (size_t)nV - 1 : 1) * sizeof(int));
+    int *labels = malloc((nV > 0 ? nV : 1) * sizeof(int));
+    if (root == NULL || label == NULL || labels == NULL) {
+        fprintf(stderr, "Couldn't allocate labels!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < 2 * nV - 1; c++) {
+        root[c] = c;
+        label[c] = -1;
+    }
+    for (int r = numKept - 1; r >= 0; r--) {
+        root[l.rows[r].left] = root[nV + r];
+        root[l.rows[r].right] = root[nV + r];
+    }
+
+    int numLabels = 0;
+    for (int v = 0; v < nV; v++) {
+        if (label[root[v]] == -1) {
+            label[root[v]] = numLabels++;
+        }
+        labels[v] = label[root[v]];
+    }
+    free(root);
+    free(label);
+    return labels;
+}
+
+// O(nV + E)
+// fills edges with one entry per pair of adjacent vertices (u < v), at
+// the same distance the matrix uses: 1 / the heavier of the two directions
+// u's out-links and in-links are both sorted by vertex, so they can be
+// merged to pair up the two directions without sorting
+// returns the number of entries
+static int collectEdges(Graph g, Edge *edges) {
+    int nV = GraphNumVertices(g);
+    int numEdges = 0;
+    for (int u = 0; u < nV; u++) {
+        AdjList out = GraphOutIncident(g, u);
+        AdjList in = GraphInIncident(g, u);
+        while (out != NULL && out->v <= u) {
+            out = out->next;
+        }
+        while (in != NULL && in->v <= u) {
+            in = in->next;
+        }
+        while (out != NULL || in != NULL) {
+            int v;
+            double a = 0;
+            double b = 0;
+            if (in == NULL || (out != NULL && out->v < in->v)) {
+                v = out->v;
+                b = out->weight;
+                out = out->next;
+            } else if (out == NULL || in->v < out->v) {
+                v = in->v;
+                a = in->weight;
+                in = in->next;
+            } else {
+                v = out->v;
+                b = out->weight;
+                a = in->weight;
+                out = out->next;
+                in = in->next;
+            }
+            edges[numEdges++] = (Edge) {u, v, calDistance(a, b)};
+        }
+    }
+    return numEdges;
+}
+
+// qsort comparator putting the shortest Edge first
+static int edgeCompare(const void *a, const void *b) {
+    const Edge *e1 = a;
+    const Edge *e2 = b;
+    return (e1->distance > e2->distance) - (e1->distance < e2->distance);
+}
+
+// O(log nV) amortised
+// union find lookup with path halving
+static int findRoot(int *parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+// O(log E)
+static void pairPush(PairHeap *h, int i, int j, int e) {
+    int pos = h->size++;
+    while (pos > 0) {
+        PairEntry parent = h->items[(pos - 1) / 2];
+        if (parent.i > i || (parent.i == i && parent.j >= j)) {
+            break;
+        }
+        h->items[pos] = parent;
+        pos = (pos - 1) / 2;
+    }
+    h->items[pos] = (PairEntry) {i, j, e};
+}
+
+// O(log E)
+static PairEntry pairPop(PairHeap *h) {
+    PairEntry top = h->items[0];
+    PairEntry last = h->items[--h->size];
+    int pos = 0;
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= h->size) {
+            break;
+        }
+        PairEntry c = h->items[child];
+        if (child + 1 < h->size) {
+            PairEntry c2 = h->items[child + 1];
+            if (c2.i > c.i || (c2.i == c.i && c2.j > c.j)) {
+                c = c2;
+                child++;
+            }
+        }
+        if (last.i > c.i || (last.i == c.i && last.j >= c.j)) {
+            break;
+        }
+        h->items[pos] = c;
+        pos = child;
+    }
+    h->items[pos] = last;
+    return top;
+}
+
+// O(expected)
+// sizes the table so 'expected' keys fit without growing
+static void mapInit(NeighbourMap *m, int expected) {
+    m->capacity = 0;
+    m->size = 0;
+    m->used = 0;
+    m->keys = NULL;
+    m->values = NULL;
+    int capacity = mapCapacity(expected);
+    if (capacity == 0) {
+        return;
+    }
+    m->keys = malloc(capacity * sizeof(int));
+    m->values = malloc(capacity * sizeof(Distance));
+    if (m->keys == NULL || m->values == NULL) {
+        fprintf(stderr, "Couldn't allocate neighbour map!\n");
+        exit(EXIT_FAILURE);
+    }
+    m->capacity = capacity;
+    for (int i = 0; i < capacity; i++) {
+        m->keys[i] = EMPTY;
+    }
+}
+
+// O(1) expected
+// returns the distance stored for key, or INFINITY if there is none
+static Distance mapGet(NeighbourMap *m, int key) {
+    int i = mapFind(m, key);
+    return i == -1 ? INFINITY : m->values[i];
+}
+
+// O(1) expected, amortised
+static void mapPut(NeighbourMap *m, int key, Distance value) {
+    int i = mapFind(m, key);
+    if (i != -1) {
+        m->values[i] = value;
+        return;
+    }
+
+    // keep at most half the table used, rebuilding without DELETED markers
+    if (2 * (m->used + 1) > m->capacity) {
+        NeighbourMap old = *m;
+        mapInit(m, old.size + 1);
+        for (int e = 0; e < old.capacity; e++) {
+            if (old.keys[e] >= 0) {
+                mapPut(m, old.keys[e], old.values[e]);
+            }
+        }
+        free(old.keys);
+        free(old.values);
+    }
+
+    unsigned mask = m->capacity - 1;
+    unsigned e = ((unsigned)key * 2654435761u) & mask;
+    while (m->keys[e] >= 0) {
+        e = (e + 1) & mask;
+    }
+    if (m->keys[e] == EMPTY) {
+        m->used++;
+    }
+    m->keys[e] = key;
+    m->values[e] = value;
+    m->size++;
+}
+
+// O(1) expected
+static void mapRemove(NeighbourMap *m, int key) {
+    int i = mapFind(m, key);
+    if (i != -1) {
+        m->keys[i] = DELETED;
+        m->size--;
+    }
+}
+
+// O(1) expected
+// returns where key is stored, or -1
+static int mapFind(NeighbourMap *m, int key) {
+    if (m->capacity == 0) {
+        return -1;
+    }
+    unsigned mask = m->capacity - 1;
+    unsigned e = ((unsigned)key * 2654435761u) & mask;
+    while (m->keys[e] != EMPTY) {
+        if (m->keys[e] == key) {
+            return e;
+        }
+        e = (e + 1) & mask;
+    }
+    return -1;
+}
+
+// O(log size), amortised
+static void candidatePush(CandidateHeap *h, Candidate c) {
+    if (h->size == h->capacity) {
+        h->capacity *= 2;
+        h->items = realloc(h->items, h->capacity * sizeof(Candidate));
+        if (h->items == NULL) {
+            fprintf(stderr, "Couldn't expand candidate heap!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int pos = h->size++;
+    while (pos > 0 && candidateCloser(c, h->items[(pos - 1) / 2])) {
+        h->items[pos] = h->items[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    h->items[pos] = c;
+}
+
+// O(log size)
+static Candidate candidatePop(CandidateHeap *h) {
+    Candidate top = h->items[0];
+    Candidate last = h->items[--h->size];
+    int pos = 0;
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= h->size) {
+            break;
+        }
+        if (child + 1 < h->size &&
+            candidateCloser(h->items[child + 1], h->items[child])) {
+            child++;
+        }
+        if (!candidateCloser(h->items[child], last)) {
+            break;
         }
+        h->items[pos] = h->items[child];
+        pos = child;
+    }
+    h->items[pos] = last;
+    return top;
 }
 
 // O(1)
-// updating distance for the new cluster
-// according to using a single linkage method
-static void completeLinkage(Shape s, int v1, int v2, int count) {
-    if(count < v1) {
-        s.distance[count][v1] = max(s.distance[count][v1],s.distance[count][v2]);
-    } else if(count > v1 && count < v2) {
-        s.distance[v1][count] = max(s.distance[v1][count],s.distance[count][v2]);
-    } else if (count > v2) {
-        s.distance[v1][count] = max(s.distance[v1][count],s.distance[v2][count]);
-    }
-}
\ No newline at end of file
+static bool candidateCloser(Candidate c1, Candidate c2) {
+    return closerPair(c1.distance, c1.i, c1.j, c2.distance, c2.i, c2.j);
+}
+
+// what LanceWilliamsLinkage holds while the merges are found: its own
+// arrays, and those of whichever of denseMerges, forestMerges or
+// sparseMerges it calls
+// O(nV + E)
+static MemoryUsage clusteringMemoryEstimate(Graph g, int method, bool sparse) {
+    int nV = GraphNumVertices(g);
+    size_t numRows = nV > 1 ? nV - 1 : 1;
+    size_t numEdges = 0;
+    for (int v = 0; v < nV; v++) {
+        for (AdjList out = GraphOutIncident(g, v); out != NULL; out = out->next) {
+            numEdges++;
+        }
+    }
+    size_t numItems = numEdges > 0 ? numEdges : 1;
+
+    MemoryUsage m = {0};
+    MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, numRows * sizeof(MergeRecord));
+    MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, numRows * sizeof(LinkageRow));
+    MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 2, nV * sizeof(int));
+    if (sparse) {
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(bool));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 3, nV * sizeof(int));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(NeighbourMap));
+        MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 1, numItems * sizeof(Edge));
+        MemoryAdd(&m, MEMORY_WORKSPACE, 1, numItems * sizeof(Candidate));
+        // each map is sized for its vertex's degree, which is at most
+        // its in and out degree together
+        for (int v = 0; v < nV; v++) {
+            int degree = 0;
+            for (AdjList out = GraphOutIncident(g, v); out != NULL;
+                 out = out->next) {
+                degree++;
+            }
+            for (AdjList in = GraphInIncident(g, v); in != NULL; in = in->next) {
+                degree++;
+            }
+            int capacity = mapCapacity(degree);
+            if (capacity > 0) {
+                MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 1, capacity * sizeof(int));
+                MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 1,
+                          capacity * sizeof(Distance));
+            }
+        }
+    } else if (method == SINGLE_LINKAGE) {
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(bool));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 3, nV * sizeof(int));
+        MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 1, numItems * sizeof(Edge));
+        MemoryAdd(&m, MEMORY_WORKSPACE, 1, numItems * sizeof(PairEntry));
+    } else {
+        // the matrix dwarfs the small arrays the search makes later
+        size_t numPairs = (size_t)nV * (nV - 1) / 2;
+        MemoryAdd(&m, MEMORY_DISTANCE_MATRIX, 1,
+                  (numPairs > 0 ? numPairs : 1) * sizeof(Distance));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(size_t));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 1, nV * sizeof(bool));
+        MemoryAdd(&m, MEMORY_VERTEX_ARRAYS, 2, nV * sizeof(int));
+        MemoryAdd(&m, MEMORY_EDGE_ARRAYS, 1, numItems * sizeof(Edge));
+        MemoryAdd(&m, MEMORY_WORKSPACE, 1, 4 * (size_t)nV * sizeof(Distance));
+    }
+    return m;
+}
+
+// the capacity mapInit gives a map for 'expected' keys, 0 for none
+static int mapCapacity(int expected) {
+    if (expected == 0) {
+        return 0;
+    }
+    int capacity = 4;
+    while (capacity < 2 * expected) {
+        capacity *= 2;
+    }
+    return capacity;
+}
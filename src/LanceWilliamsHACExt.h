@@ -0,0 +1,104 @@
+// Lance-Williams HAC API extensions
+// COMP2521 Assignment 2
+
+// More linkage methods, a sparse mode and a flat linkage output, added on
+// top of LanceWilliamsHAC.h, which is fixed by the assignment and so left
+// exactly as it was given. LanceWilliamsHAC accepts every method below
+// as well as SINGLE_LINKAGE and COMPLETE_LINKAGE. Clusters with no edges
+// between them stay missing until everything else is merged, and a
+// missing distance never contributes to a linkage: the merged cluster
+// keeps the distance it has.
+
+#ifndef LANCE_WILLIAMS_HAC_EXT_H
+#define LANCE_WILLIAMS_HAC_EXT_H
+
+#include <stdbool.h>
+
+#include "Graph.h"
+#include "LanceWilliamsHAC.h"
+#include "MemoryUsage.h"
+
+#define AVERAGE_LINKAGE  3 // UPGMA
+#define WEIGHTED_LINKAGE 4 // WPGMA
+#define WARD_LINKAGE     5
+#define CENTROID_LINKAGE 6
+#define MEDIAN_LINKAGE   7
+
+// One merge of a Linkage, in the layout of SciPy's linkage matrix. The
+// vertices are clusters 0 to nV - 1, and the cluster made by row r is
+// cluster nV + r.
+typedef struct LinkageRow {
+	int left;        // The two clusters that were merged, as in the left
+	int right;       // and right children of a Dendrogram
+	double distance; // The distance between them when they were merged,
+	                 // or HUGE_VAL if no edge joined them
+	int size;        // The number of vertices in the new cluster
+} LinkageRow;
+
+typedef struct Linkage {
+	int numVertices;
+	LinkageRow *rows; // numVertices - 1 rows, in the order of the merges
+} Linkage;
+
+/**
+ * Generates the same Dendrogram as LanceWilliamsHAC, but only stores the
+ * distances  between  clusters that are joined by edges. Time and memory
+ * grow with the number of edges instead of nV^2, which suits graphs where
+ * most pairs of vertices have no edge between them.
+ */
+Dendrogram LanceWilliamsHACSparse(Graph g, int method);
+
+/**
+ * Clusters  the  graph  exactly like LanceWilliamsHAC (or, if 'sparse' is
+ * true, LanceWilliamsHACSparse), but returns the merges as one flat array
+ * of rows instead of a tree of nodes. The rows are in the order of the
+ * merges, which is also the order of increasing distance except where a
+ * centroid or median linkage merge is closer than the one before it.
+ */
+Linkage LanceWilliamsLinkage(Graph g, int method, bool sparse);
+
+/**
+ * Cuts  the  hierarchy into k clusters (1 <= k <= nV) by undoing its last
+ * k - 1 merges,  and  returns  an array of nV labels from 0 to k - 1, so
+ * that two vertices have the same label exactly when they are in the same
+ * cluster. Labels are numbered in order of each cluster's lowest vertex.
+ */
+int *linkageCutClusters(Linkage l, int k);
+
+/**
+ * Cuts  the  hierarchy  just before the first merge at a distance above
+ * 'threshold', and returns labels as for linkageCutClusters.
+ */
+int *linkageCutDistance(Linkage l, double threshold);
+
+/**
+ * Builds the Dendrogram that matches the given Linkage.
+ */
+Dendrogram linkageToDendrogram(Linkage l);
+
+/**
+ * Frees all memory associated with the given Linkage structure.
+ */
+void freeLinkage(Linkage l);
+
+/**
+ * Returns the memory held by the given Dendrogram, which must be a root
+ * returned by one of the functions above.
+ */
+MemoryUsage dendrogramMemoryUsage(Dendrogram d);
+
+/**
+ * Returns the memory held by the given Linkage.
+ */
+MemoryUsage linkageMemoryUsage(Linkage l);
+
+/**
+ * Returns the most memory LanceWilliamsHAC(g, method) holds at once, or
+ * LanceWilliamsHACSparse(g, method) if 'sparse' is true, including the
+ * Dendrogram it returns. LanceWilliamsLinkage never holds more. The
+ * sparse estimate is for the maps and heap as first built, which merges
+ * can grow.
+ */
+MemoryUsage LanceWilliamsMemoryEstimate(Graph g, int method, bool sparse);
+
+#endif
@@ -0,0 +1,64 @@
+// Memory accounting for graphs and algorithm results implementation
+// COMP2521 Assignment 2
+
+#include <stdio.h>
+
+#include "MemoryUsage.h"
+
+// glibc's malloc, on 64 bit machines
+#define HEADER_BYTES 8
+#define BLOCK_ALIGN 16
+#define MIN_BLOCK 32
+#define MMAP_THRESHOLD (128 * 1024)
+#define PAGE_BYTES 4096
+
+static const char *componentNames[MEMORY_NUM_COMPONENTS] = {
+	"header", "outLists", "inLists", "vertexArrays", "edgeArrays",
+	"predLists", "distanceMatrix", "treeNodes", "workspace",
+};
+
+void MemoryAdd(MemoryUsage *m, MemoryComponent c, size_t count,
+               size_t bytes) {
+	size_t overhead = count * MemoryOverhead(bytes);
+	m->bytes[c] = m->bytes[c] + count * bytes;
+	m->overhead = m->overhead + overhead;
+	m->total = m->total + count * bytes + overhead;
+}
+
+void MemoryCombine(MemoryUsage *m, MemoryUsage part) {
+	for (int c = 0; c < MEMORY_NUM_COMPONENTS; c++) {
+		m->bytes[c] = m->bytes[c] + part.bytes[c];
+	}
+	m->overhead = m->overhead + part.overhead;
+	m->total = m->total + part.total;
+}
+
+size_t MemoryOverhead(size_t bytes) {
+	size_t block;
+	if (bytes + HEADER_BYTES >= MMAP_THRESHOLD) {
+		// mmapped blocks have a 16 byte header and fill whole pages
+		block = (bytes + 2 * HEADER_BYTES + PAGE_BYTES - 1) /
+		        PAGE_BYTES * PAGE_BYTES;
+	} else {
+		block = (bytes + HEADER_BYTES + BLOCK_ALIGN - 1) /
+		        BLOCK_ALIGN * BLOCK_ALIGN;
+		if (block < MIN_BLOCK) {
+			block = MIN_BLOCK;
+		}
+	}
+	return block - bytes;
+}
+
+void MemoryUsageShow(MemoryUsage m) {
+	for (int c = 0; c < MEMORY_NUM_COMPONENTS; c++) {
+		if (m.bytes[c] != 0) {
+			printf("%-15s %zu\n", componentNames[c], m.bytes[c]);
+		}
+	}
+	printf("%-15s %zu\n", "overhead", m.overhead);
+	printf("%-15s %zu\n", "total", m.total);
+}
+
+const char *MemoryComponentName(MemoryComponent c) {
+	return componentNames[c];
+}
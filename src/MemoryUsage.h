@@ -0,0 +1,70 @@
+// Memory accounting for graphs and algorithm results
+// COMP2521 Assignment 2
+
+// Each structure has a *MemoryUsage function that adds up the memory it
+// holds, broken down by what it is used for, and each algorithm that
+// needs a lot of memory has a *MemoryEstimate function that predicts the
+// most it will hold at once while running, from the graph alone. A job
+// that won't fit can then be turned down, or given to a cheaper version
+// (such as LanceWilliamsHACSparse), before anything is allocated.
+//
+// malloc hands out more than it is asked for: glibc adds an 8 byte header
+// to each block, rounds it up to a multiple of 16 (and at least 32), and
+// blocks of 128 KiB or more are whole pages of their own. That overhead
+// is estimated separately, as it dominates for small list nodes.
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <stddef.h>
+
+typedef enum {
+	MEMORY_HEADER,          // the structs themselves
+	MEMORY_OUT_LISTS,       // outgoing adjacency list nodes
+	MEMORY_IN_LISTS,        // incoming adjacency list nodes
+	MEMORY_VERTEX_ARRAYS,   // arrays with an entry per vertex
+	MEMORY_EDGE_ARRAYS,     // arrays with an entry per edge
+	MEMORY_PRED_LISTS,      // shortest path predecessor list nodes
+	MEMORY_DISTANCE_MATRIX, // the HAC distance matrix
+	MEMORY_TREE_NODES,      // dendrogram nodes
+	MEMORY_WORKSPACE,       // per thread scratch space of an algorithm
+	MEMORY_NUM_COMPONENTS
+} MemoryComponent;
+
+typedef struct MemoryUsage {
+	size_t bytes[MEMORY_NUM_COMPONENTS]; // asked for, indexed by
+	                                     // MemoryComponent
+	size_t overhead;                     // allocator headers and rounding
+	                                     // on top of those
+	size_t total;                        // everything, overhead included
+} MemoryUsage;
+
+/**
+ * Records 'count' blocks of 'bytes' bytes each, asked for from malloc,
+ * under the given component.
+ */
+void MemoryAdd(MemoryUsage *m, MemoryComponent c, size_t count,
+               size_t bytes);
+
+/**
+ * Adds everything recorded in 'part' to 'm'.
+ */
+void MemoryCombine(MemoryUsage *m, MemoryUsage part);
+
+/**
+ * Returns the estimated overhead malloc adds to a block of the given size.
+ */
+size_t MemoryOverhead(size_t bytes);
+
+/**
+ * Prints the breakdown to stdout, one component per line, skipping
+ * components that use nothing.
+ */
+void MemoryUsageShow(MemoryUsage m);
+
+/**
+ * The name MemoryUsageShow prints for a component.
+ */
+const char *MemoryComponentName(MemoryComponent c);
+
+#endif
@@ -12,6 +12,8 @@
 #include <stdlib.h>
 
 #include "PQ.h"
+#include "PQExt.h"
+#include "Stats.h"
 
 #define DEFAULT_SIZE 64
 
@@ -46,6 +48,8 @@ PQ PQNew(void) {
 
 void PQInsert(PQ pq, int item, int priority) {
 	assert(pq != NULL);
+	STATS_ADD(STATS_PQ_INSERTS, 1);
+	STATS_ADD(STATS_PQ_SCANNED, pq->numItems);
 
 	// If item is already in the PQ, use updatePQ
 	for (int i = 0; i < pq->numItems; i++) {
@@ -73,6 +77,8 @@ void PQInsert(PQ pq, int item, int priority) {
 int PQDequeue(PQ pq) {
 	assert(pq != NULL);
 	assert(pq->numItems > 0);
+	STATS_ADD(STATS_PQ_DEQUEUES, 1);
+	STATS_ADD(STATS_PQ_SCANNED, pq->numItems);
 
 	// Find earliest element with smallest value (highest priority)
 	int chosenIndex = 0;
@@ -94,6 +100,8 @@ int PQDequeue(PQ pq) {
 
 void PQUpdate(PQ pq, int item, int priority) {
 	assert(pq != NULL);
+	STATS_ADD(STATS_PQ_UPDATES, 1);
+	STATS_ADD(STATS_PQ_SCANNED, pq->numItems);
 
 	for (int i = 0; i < pq->numItems; i++) {
 		if (pq->items[i].item == item) {
@@ -135,3 +143,14 @@ void PQFree(PQ pq) {
 	free(pq);
 }
 
+
+MemoryUsage PQMemoryEstimate(int numItems) {
+	MemoryUsage m = {0};
+	int capacity = DEFAULT_SIZE;
+	while (capacity < numItems) {
+		capacity *= 2;
+	}
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(struct PQRep));
+	MemoryAdd(&m, MEMORY_WORKSPACE, 1, capacity * sizeof(ItemPQ));
+	return m;
+}
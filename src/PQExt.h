@@ -0,0 +1,19 @@
+// Priority queue ADT interface extensions
+// COMP2521 Assignment 2
+
+// Memory accounting for the priority queue, added on top of PQ.h, which
+// is fixed by the assignment and so left exactly as it was given.
+
+#ifndef PQ_EXT_H
+#define PQ_EXT_H
+
+#include "MemoryUsage.h"
+#include "PQ.h"
+
+/**
+ * Returns the memory a new priority queue holds once 'numItems' items
+ * have been inserted, counted as workspace
+ */
+MemoryUsage PQMemoryEstimate(int numItems);
+
+#endif
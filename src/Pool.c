@@ -0,0 +1,236 @@
+// Fixed size pool allocator implementation
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Pool.h"
+
+// bytes in a page, which is also its alignment
+#define PAGE_BYTES 256
+
+// the largest chunk, in pages
+#define MAX_CHUNK_PAGES 64
+
+// every item is a multiple of this, so any type can be stored in one
+#define ITEM_ALIGN (sizeof(void *))
+
+// rounds n up to a multiple of ITEM_ALIGN
+#define ALIGN_UP(n) (((n) + ITEM_ALIGN - 1) / ITEM_ALIGN * ITEM_ALIGN)
+
+// sits at the start of every page but the first of a chunk
+typedef struct page {
+	Pool pool;
+} Page;
+
+// sits at the start of the first page of every chunk
+typedef struct chunk {
+	Pool pool;
+	struct chunk *next;
+	size_t numPages;
+} Chunk;
+
+// the headers rounded up so the first item of a page is aligned
+#define PAGE_HEADER_BYTES ALIGN_UP(sizeof(Page))
+#define CHUNK_HEADER_BYTES ALIGN_UP(sizeof(Chunk))
+
+// a released item, linked through its own first bytes
+typedef struct freeItem {
+	struct freeItem *next;
+} FreeItem;
+
+struct PoolRep {
+	size_t itemSize;
+	Chunk *chunks;      // every chunk, newest first
+	size_t numChunks;
+	char *next;         // the next untouched item of the current page
+	char *end;          // one past the last item of the current page
+	char *nextPage;     // the next untouched page of the newest chunk
+	char *chunkEnd;     // one past the last page of the newest chunk
+	FreeItem *released; // items given back by PoolRelease
+	const void *owner;  // the item set by PoolSetOwner, or NULL
+	size_t numLive;     // items allocated and not released
+};
+
+static void newChunk(Pool p);
+static void startPage(Pool p, char *page, size_t headerBytes);
+static size_t chunkPages(size_t numChunks);
+static size_t chunkItems(size_t numPages, size_t itemSize);
+static size_t roundItemSize(size_t itemSize);
+
+Pool PoolNew(size_t itemSize) {
+	assert(itemSize > 0 && itemSize <= PAGE_BYTES - CHUNK_HEADER_BYTES);
+
+	Pool p = malloc(sizeof(*p));
+	if (p == NULL) {
+		fprintf(stderr, "Couldn't allocate pool!\n");
+		exit(EXIT_FAILURE);
+	}
+	p->itemSize = roundItemSize(itemSize);
+	p->chunks = NULL;
+	p->numChunks = 0;
+	p->next = NULL;
+	p->end = NULL;
+	p->nextPage = NULL;
+	p->chunkEnd = NULL;
+	p->released = NULL;
+	p->owner = NULL;
+	p->numLive = 0;
+	return p;
+}
+
+// O(chunks)
+void PoolFree(Pool p) {
+	if (p == NULL) {
+		return;
+	}
+	Chunk *c = p->chunks;
+	while (c != NULL) {
+		Chunk *next = c->next;
+		free(c);
+		c = next;
+	}
+	free(p);
+}
+
+void *PoolAlloc(Pool p) {
+	assert(p != NULL);
+
+	p->numLive++;
+	if (p->released != NULL) {
+		FreeItem *item = p->released;
+		p->released = item->next;
+		return item;
+	}
+	if (p->next == p->end) {
+		if (p->nextPage == p->chunkEnd) {
+			newChunk(p);
+		} else {
+			startPage(p, p->nextPage, PAGE_HEADER_BYTES);
+		}
+	}
+	void *item = p->next;
+	p->next = p->next + p->itemSize;
+	return item;
+}
+
+void PoolRelease(Pool p, void *item) {
+	assert(p != NULL && PoolOf(item) == p);
+
+	if (item == p->owner) {
+		p->owner = NULL;
+	}
+	p->numLive--;
+	FreeItem *f = item;
+	f->next = p->released;
+	p->released = f;
+}
+
+Pool PoolOf(const void *item) {
+	assert(item != NULL);
+
+	Page *page = (Page *)((uintptr_t)item & ~(uintptr_t)(PAGE_BYTES - 1));
+	return page->pool;
+}
+
+void PoolSetOwner(Pool p, const void *owner) {
+	assert(p != NULL && (owner == NULL || PoolOf(owner) == p));
+	p->owner = owner;
+}
+
+const void *PoolOwner(Pool p) {
+	assert(p != NULL);
+	return p->owner;
+}
+
+size_t PoolNumLive(Pool p) {
+	assert(p != NULL);
+	return p->numLive;
+}
+
+// O(chunks)
+MemoryUsage PoolMemoryUsage(Pool p, MemoryComponent c) {
+	MemoryUsage m = {0};
+	if (p == NULL) {
+		return m;
+	}
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(*p));
+	for (Chunk *chunk = p->chunks; chunk != NULL; chunk = chunk->next) {
+		MemoryAdd(&m, c, 1, chunk->numPages * PAGE_BYTES);
+	}
+	return m;
+}
+
+// O(chunks)
+MemoryUsage PoolMemoryEstimate(size_t itemSize, size_t numItems,
+                               MemoryComponent c) {
+	MemoryUsage m = {0};
+	itemSize = roundItemSize(itemSize);
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(struct PoolRep));
+	size_t numChunks = 0;
+	while (numItems > 0) {
+		size_t numPages = chunkPages(numChunks++);
+		size_t held = chunkItems(numPages, itemSize);
+		MemoryAdd(&m, c, 1, numPages * PAGE_BYTES);
+		numItems = numItems > held ? numItems - held : 0;
+	}
+	return m;
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// adds an empty chunk, twice the size of the last one, and starts handing
+// out items from its first page
+static void newChunk(Pool p) {
+	size_t numPages = chunkPages(p->numChunks);
+	Chunk *c = aligned_alloc(PAGE_BYTES, numPages * PAGE_BYTES);
+	if (c == NULL) {
+		fprintf(stderr, "Couldn't allocate pool chunk!\n");
+		exit(EXIT_FAILURE);
+	}
+	c->next = p->chunks;
+	c->numPages = numPages;
+	p->chunks = c;
+	p->numChunks++;
+
+	p->chunkEnd = (char *)c + numPages * PAGE_BYTES;
+	startPage(p, (char *)c, CHUNK_HEADER_BYTES);
+}
+
+// marks the page as the pool's and starts handing out items from it
+static void startPage(Pool p, char *page, size_t headerBytes) {
+	((Page *)page)->pool = p;
+	size_t numItems = (PAGE_BYTES - headerBytes) / p->itemSize;
+	p->next = page + headerBytes;
+	p->end = p->next + numItems * p->itemSize;
+	p->nextPage = page + PAGE_BYTES;
+}
+
+// the pages in a pool's chunk after it already has numChunks:
+// 1, 2, 4, ... up to MAX_CHUNK_PAGES
+static size_t chunkPages(size_t numChunks) {
+	size_t numPages = 1;
+	while (numChunks > 0 && numPages < MAX_CHUNK_PAGES) {
+		numPages = numPages * 2;
+		numChunks--;
+	}
+	return numPages;
+}
+
+// the items a chunk of numPages holds
+static size_t chunkItems(size_t numPages, size_t itemSize) {
+	return (PAGE_BYTES - CHUNK_HEADER_BYTES) / itemSize +
+	       (numPages - 1) * ((PAGE_BYTES - PAGE_HEADER_BYTES) / itemSize);
+}
+
+// every item must be able to hold a FreeItem, and be aligned
+static size_t roundItemSize(size_t itemSize) {
+	if (itemSize < sizeof(FreeItem)) {
+		itemSize = sizeof(FreeItem);
+	}
+	return ALIGN_UP(itemSize);
+}
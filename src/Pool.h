@@ -0,0 +1,92 @@
+// Fixed size pool allocator
+// COMP2521 Assignment 2
+
+// Hands out items of one size from chunks instead of calling malloc for
+// each one, so the items of a structure sit next to each other and carry
+// no per item header. Every item of a pool is released at once by
+// PoolFree, which only visits the chunks.
+// A chunk is made of small aligned pages, each starting with a pointer to
+// its pool, so the pool an item came from can be found from the item
+// alone (PoolOf). A linked structure that owns a pool therefore needs no
+// extra field to find it: any of its nodes will do. The first chunk is a
+// single page and each later one is twice the size of the last (up to a
+// limit), so a small structure holds little more than it uses.
+// A pool can record the item that owns it, usually the root of the
+// structure, so freeing the whole structure can be told apart from
+// freeing part of it. A pool is not safe to use from more than one
+// thread at a time.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+#include "MemoryUsage.h"
+
+typedef struct PoolRep *Pool;
+
+/**
+ * Creates an empty pool of items of 'itemSize' bytes. Nothing is
+ * allocated for the items until the first PoolAlloc.
+ */
+Pool PoolNew(size_t itemSize);
+
+/**
+ * Frees the pool and every item allocated from it, in O(chunks).
+ */
+void PoolFree(Pool p);
+
+/**
+ * Returns an uninitialised item from the pool, reusing one given back
+ * by PoolRelease if there is one.
+ * O(1)
+ */
+void *PoolAlloc(Pool p);
+
+/**
+ * Gives an item back to its pool, to be handed out again by PoolAlloc.
+ * The memory stays with the pool until PoolFree.
+ * O(1)
+ */
+void PoolRelease(Pool p, void *item);
+
+/**
+ * Returns the pool the given item was allocated from.
+ * O(1)
+ */
+Pool PoolOf(const void *item);
+
+/**
+ * Records 'owner' as the item that owns the pool, or none if it is NULL.
+ * Releasing the owner clears it.
+ * O(1)
+ */
+void PoolSetOwner(Pool p, const void *owner);
+
+/**
+ * Returns the item recorded by PoolSetOwner, or NULL if there is none.
+ * O(1)
+ */
+const void *PoolOwner(Pool p);
+
+/**
+ * Returns the number of items allocated and not yet released.
+ * O(1)
+ */
+size_t PoolNumLive(Pool p);
+
+/**
+ * Returns the memory the pool holds, counting its chunks (used or not)
+ * under the given component.
+ * O(chunks)
+ */
+MemoryUsage PoolMemoryUsage(Pool p, MemoryComponent c);
+
+/**
+ * Returns the memory a new pool of items of 'itemSize' bytes will hold
+ * once 'numItems' items have been allocated from it.
+ */
+MemoryUsage PoolMemoryEstimate(size_t itemSize, size_t numItems,
+                               MemoryComponent c);
+
+#endif
@@ -0,0 +1,398 @@
+// Single source shortest path kernels used by the centrality measures
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// math.h defines INFINITY as a float, Dijkstra.h needs it to be INT_MAX
+#undef INFINITY
+
+#include "CompactGraph.h"
+#include "Dijkstra.h"
+#include "Graph.h"
+#include "SSSP.h"
+#include "Stats.h"
+
+static void resetRun(SSSP s);
+static void touch(SSSP s, Vertex v, int dist, double sigma);
+static inline void addPaths(SSSP s, Vertex v, Vertex u);
+static void heapPush(SSSP s, Vertex v);
+static Vertex heapPop(SSSP s);
+static void siftUp(SSSP s, int i);
+static void siftDown(SSSP s, int i);
+static inline __attribute__((always_inline))
+void runKernel(SSSP s, CompactGraph cg, Vertex src, bool withPaths,
+               int vertexBytes, int weightBytes);
+static inline __attribute__((always_inline))
+void accumulateKernel(SSSP s, CompactGraph cg, double *delta,
+                      int vertexBytes, int weightBytes);
+
+SSSP SSSPNew(int numNodes) {
+	assert(numNodes > 0);
+
+	SSSP s = malloc(sizeof(*s));
+	if (s == NULL) {
+		fprintf(stderr, "Couldn't allocate SSSP!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	s->numNodes = numNodes;
+	s->src = -1;
+	s->dist = malloc(numNodes * sizeof(int));
+	s->sigma = calloc(numNodes, sizeof(double));
+	s->order = malloc(numNodes * sizeof(Vertex));
+	s->touched = malloc(numNodes * sizeof(Vertex));
+	s->heap = malloc(numNodes * sizeof(Vertex));
+	s->heapPos = malloc(numNodes * sizeof(int));
+	if (s->dist == NULL || s->sigma == NULL || s->order == NULL ||
+	    s->touched == NULL || s->heap == NULL || s->heapPos == NULL) {
+		fprintf(stderr, "Couldn't allocate SSSP!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int i = 0; i < numNodes; i++) {
+		s->dist[i] = INFINITY;
+		s->heapPos[i] = -1;
+	}
+	s->numSettled = 0;
+	s->numTouched = 0;
+	s->heapSize = 0;
+	return s;
+}
+
+void SSSPFree(SSSP s) {
+	assert(s != NULL);
+
+	free(s->dist);
+	free(s->sigma);
+	free(s->order);
+	free(s->touched);
+	free(s->heap);
+	free(s->heapPos);
+	free(s);
+}
+
+MemoryUsage SSSPMemoryEstimate(int numNodes) {
+	MemoryUsage m = {0};
+	MemoryAdd(&m, MEMORY_HEADER, 1, sizeof(struct SSSPRep));
+	MemoryAdd(&m, MEMORY_WORKSPACE, 1, numNodes * sizeof(int));
+	MemoryAdd(&m, MEMORY_WORKSPACE, 1, numNodes * sizeof(double));
+	MemoryAdd(&m, MEMORY_WORKSPACE, 4, numNodes * sizeof(Vertex));
+	return m;
+}
+
+// O((V + E) log V) over the explored part of the graph
+void SSSPRun(SSSP s, Graph g, Vertex src, Vertex target) {
+	assert(s != NULL && g != NULL);
+	assert(GraphNumVertices(g) == s->numNodes);
+	assert(src >= 0 && src < s->numNodes);
+
+	resetRun(s);
+	s->src = src;
+	touch(s, src, 0, 1);
+
+	while (s->heapSize > 0) {
+		Vertex u = heapPop(s);
+		s->order[s->numSettled++] = u;
+		if (u == target) {
+			break;
+		}
+
+		for (AdjList curr = GraphOutIncident(g, u); curr != NULL;
+		     curr = curr->next) {
+			Vertex v = curr->v;
+			int alt = s->dist[u] + curr->weight;
+			STATS_ADD(STATS_RELAXATIONS, 1);
+			if (s->dist[v] == INFINITY) {
+				touch(s, v, alt, s->sigma[u]);
+			} else if (alt < s->dist[v]) {
+				// a shorter path replaces every path counted so far
+				s->dist[v] = alt;
+				s->sigma[v] = s->sigma[u];
+				siftUp(s, s->heapPos[v]);
+			} else if (alt == s->dist[v]) {
+				addPaths(s, v, u);
+			}
+		}
+	}
+}
+
+// O(V + E) over the settled part of the graph
+// Walks the settled vertices from furthest to closest, pushing each
+// one's dependency back to its predecessors on the shortest path DAG
+void SSSPAccumulate(SSSP s, Graph g, double *delta) {
+	assert(s != NULL && g != NULL && delta != NULL);
+
+	for (int i = 0; i < s->numSettled; i++) {
+		delta[s->order[i]] = 0;
+	}
+	for (int i = s->numSettled - 1; i > 0; i--) {
+		Vertex w = s->order[i];
+		double share = (1 + delta[w]) / s->sigma[w];
+		for (AdjList in = GraphInIncident(g, w); in != NULL; in = in->next) {
+			Vertex u = in->v;
+			if (s->dist[u] != INFINITY &&
+			    s->dist[u] + in->weight == s->dist[w]) {
+				delta[u] = delta[u] + s->sigma[u] * share;
+			}
+		}
+	}
+}
+
+// O((V + E) log V)
+void SSSPRunDistances(SSSP s, Graph g, Vertex src) {
+	assert(s != NULL && g != NULL);
+	assert(GraphNumVertices(g) == s->numNodes);
+
+	SSSPStart(s, src);
+	while (SSSPSettleNext(s, g) != -1);
+}
+
+void SSSPStart(SSSP s, Vertex src) {
+	assert(s != NULL);
+	assert(src >= 0 && src < s->numNodes);
+
+	resetRun(s);
+	s->src = src;
+	touch(s, src, 0, 0);
+}
+
+// O(out degree * log V)
+Vertex SSSPSettleNext(SSSP s, Graph g) {
+	assert(s != NULL && g != NULL);
+	if (s->heapSize == 0) {
+		return -1;
+	}
+
+	Vertex u = heapPop(s);
+	s->order[s->numSettled++] = u;
+	for (AdjList curr = GraphOutIncident(g, u); curr != NULL;
+	     curr = curr->next) {
+		Vertex v = curr->v;
+		int alt = s->dist[u] + curr->weight;
+		STATS_ADD(STATS_RELAXATIONS, 1);
+		if (s->dist[v] == INFINITY) {
+			touch(s, v, alt, 0);
+		} else if (alt < s->dist[v]) {
+			s->dist[v] = alt;
+			siftUp(s, s->heapPos[v]);
+		}
+	}
+	return u;
+}
+
+int SSSPFrontierDist(SSSP s) {
+	assert(s != NULL);
+	return s->heapSize == 0 ? INFINITY : s->dist[s->heap[0]];
+}
+
+int SSSPNumQueued(SSSP s) {
+	assert(s != NULL);
+	return s->heapSize;
+}
+
+// O((V + E) log V), or O(V + E) if every edge has the same weight
+void SSSPRunCompact(SSSP s, CompactGraph cg, Vertex src) {
+	assert(s != NULL && cg != NULL);
+	assert(cg->numNodes == s->numNodes);
+	assert(src >= 0 && src < s->numNodes);
+
+	COMPACT_DISPATCH(cg, runKernel, s, cg, src, true);
+}
+
+// O(V + E) over the settled part of the graph
+void SSSPAccumulateCompact(SSSP s, CompactGraph cg, double *delta) {
+	assert(s != NULL && cg != NULL && delta != NULL);
+
+	COMPACT_DISPATCH(cg, accumulateKernel, s, cg, delta);
+}
+
+// O((V + E) log V), or O(V + E) if every edge has the same weight
+void SSSPRunDistancesCompact(SSSP s, CompactGraph cg, Vertex src) {
+	assert(s != NULL && cg != NULL);
+	assert(cg->numNodes == s->numNodes);
+	assert(src >= 0 && src < s->numNodes);
+
+	COMPACT_DISPATCH(cg, runKernel, s, cg, src, false);
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// clears everything the previous run wrote
+// O(number of touched vertices)
+static void resetRun(SSSP s) {
+	for (int i = 0; i < s->numTouched; i++) {
+		Vertex v = s->touched[i];
+		s->dist[v] = INFINITY;
+		s->sigma[v] = 0;
+		s->heapPos[v] = -1;
+	}
+	s->numTouched = 0;
+	s->numSettled = 0;
+	s->heapSize = 0;
+}
+
+// records the first time a vertex is reached and queues it
+static void touch(SSSP s, Vertex v, int dist, double sigma) {
+	s->dist[v] = dist;
+	s->sigma[v] = sigma;
+	s->touched[s->numTouched++] = v;
+	heapPush(s, v);
+}
+
+// adds the shortest paths to u onto those to v
+// the counts grow exponentially on chains of diamonds, and once one is
+// infinite the dependencies become inf * 0 = NaN, so that is an error,
+// as it is for the path counts of betweennessCentrality
+static inline void addPaths(SSSP s, Vertex v, Vertex u) {
+	s->sigma[v] = s->sigma[v] + s->sigma[u];
+	if (isinf(s->sigma[v])) {
+		fprintf(stderr, "Shortest path count overflowed a double\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void heapPush(SSSP s, Vertex v) {
+	s->heap[s->heapSize] = v;
+	s->heapPos[v] = s->heapSize;
+	s->heapSize++;
+	siftUp(s, s->heapSize - 1);
+}
+
+static Vertex heapPop(SSSP s) {
+	Vertex top = s->heap[0];
+	s->heapSize--;
+	if (s->heapSize > 0) {
+		s->heap[0] = s->heap[s->heapSize];
+		s->heapPos[s->heap[0]] = 0;
+		siftDown(s, 0);
+	}
+	s->heapPos[top] = -1;
+	return top;
+}
+
+static void siftUp(SSSP s, int i) {
+	Vertex v = s->heap[i];
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (s->dist[s->heap[parent]] <= s->dist[v]) {
+			break;
+		}
+		s->heap[i] = s->heap[parent];
+		s->heapPos[s->heap[i]] = i;
+		i = parent;
+	}
+	s->heap[i] = v;
+	s->heapPos[v] = i;
+}
+
+static void siftDown(SSSP s, int i) {
+	Vertex v = s->heap[i];
+	for (;;) {
+		int child = 2 * i + 1;
+		if (child >= s->heapSize) {
+			break;
+		}
+		if (child + 1 < s->heapSize &&
+		    s->dist[s->heap[child + 1]] < s->dist[s->heap[child]]) {
+			child++;
+		}
+		if (s->dist[s->heap[child]] >= s->dist[v]) {
+			break;
+		}
+		s->heap[i] = s->heap[child];
+		s->heapPos[s->heap[i]] = i;
+		i = child;
+	}
+	s->heap[i] = v;
+	s->heapPos[v] = i;
+}
+
+// SSSPRun (or SSSPRunDistances without paths) over a snapshot, compiled
+// once for each layout by COMPACT_DISPATCH
+static inline __attribute__((always_inline))
+void runKernel(SSSP s, CompactGraph cg, Vertex src, bool withPaths,
+               int vertexBytes, int weightBytes) {
+	const int *start = cg->outStart;
+	resetRun(s);
+	s->src = src;
+
+	if (weightBytes == 0 && cg->weight > 0) {
+		// every vertex first reached on a level is one edge further than
+		// the last, so order doubles as the queue and nothing is ever
+		// reached by a shorter path later
+		s->dist[src] = 0;
+		s->sigma[src] = withPaths ? 1 : 0;
+		s->touched[s->numTouched++] = src;
+		s->order[0] = src;
+		int numQueued = 1;
+		for (int head = 0; head < numQueued; head++) {
+			Vertex u = s->order[head];
+			int alt = s->dist[u] + cg->weight;
+			STATS_ADD(STATS_RELAXATIONS, start[u + 1] - start[u]);
+			for (int e = start[u]; e < start[u + 1]; e++) {
+				Vertex v = compactVertex(cg->outTo, vertexBytes, e);
+				if (s->dist[v] == INFINITY) {
+					s->dist[v] = alt;
+					s->sigma[v] = withPaths ? s->sigma[u] : 0;
+					s->touched[s->numTouched++] = v;
+					s->order[numQueued++] = v;
+				} else if (withPaths && s->dist[v] == alt) {
+					addPaths(s, v, u);
+				}
+			}
+		}
+		s->numSettled = numQueued;
+		return;
+	}
+
+	touch(s, src, 0, withPaths ? 1 : 0);
+	while (s->heapSize > 0) {
+		Vertex u = heapPop(s);
+		s->order[s->numSettled++] = u;
+		for (int e = start[u]; e < start[u + 1]; e++) {
+			Vertex v = compactVertex(cg->outTo, vertexBytes, e);
+			int alt = s->dist[u] +
+			          compactWeight(cg, cg->outWeight, weightBytes, e);
+			STATS_ADD(STATS_RELAXATIONS, 1);
+			if (s->dist[v] == INFINITY) {
+				touch(s, v, alt, withPaths ? s->sigma[u] : 0);
+			} else if (alt < s->dist[v]) {
+				s->dist[v] = alt;
+				if (withPaths) {
+					s->sigma[v] = s->sigma[u];
+				}
+				siftUp(s, s->heapPos[v]);
+			} else if (withPaths && alt == s->dist[v]) {
+				addPaths(s, v, u);
+			}
+		}
+	}
+}
+
+// SSSPAccumulate over a snapshot, compiled once for each layout
+static inline __attribute__((always_inline))
+void accumulateKernel(SSSP s, CompactGraph cg, double *delta,
+                      int vertexBytes, int weightBytes) {
+	const int *start = cg->inStart;
+	for (int i = 0; i < s->numSettled; i++) {
+		delta[s->order[i]] = 0;
+	}
+	for (int i = s->numSettled - 1; i > 0; i--) {
+		Vertex w = s->order[i];
+		double share = (1 + delta[w]) / s->sigma[w];
+		for (int e = start[w]; e < start[w + 1]; e++) {
+			Vertex u = compactVertex(cg->inFrom, vertexBytes, e);
+			if (s->dist[u] != INFINITY &&
+			    s->dist[u] + compactWeight(cg, cg->inWeight, weightBytes, e) ==
+			    s->dist[w]) {
+				delta[u] = delta[u] + s->sigma[u] * share;
+			}
+		}
+	}
+}
@@ -0,0 +1,131 @@
+// Single source shortest path kernels used by the centrality measures
+// COMP2521 Assignment 2
+
+// Unlike dijkstra() in Dijkstra.h, these kernels do not build
+// predecessor lists. A vertex u is a predecessor of w on a shortest
+// path exactly when dist[u] + weight(u, w) == dist[w], so callers walk
+// GraphInIncident(g, w) to recover the shortest path DAG on demand.
+// The workspace is allocated once and reused for every source.
+// The *Compact versions run the same searches over a CompactGraph, which
+// is worth taking when many searches are run on a graph that isn't
+// changing.
+
+#ifndef SSSP_H
+#define SSSP_H
+
+#include "CompactGraph.h"
+#include "Dijkstra.h"
+#include "Graph.h"
+#include "MemoryUsage.h"
+
+typedef struct SSSPRep *SSSP;
+struct SSSPRep {
+	int numNodes;     // The number of vertices in the graph
+
+	Vertex src;       // The source vertex of the last run
+
+	int *dist;        // dist[v] is the shortest distance from src to v,
+	                  // or INFINITY if v was not reached
+
+	double *sigma;    // sigma[v] is the number of shortest paths from
+	                  // src to v (only valid for settled vertices)
+
+	Vertex *order;    // The settled vertices, in the order they were
+	int numSettled;   // removed from the heap (non-decreasing dist)
+
+	// Internal state, callers should not touch these
+	Vertex *touched;  // Every vertex whose dist was set in this run
+	int numTouched;
+	Vertex *heap;     // Binary min-heap of vertices keyed on dist
+	int *heapPos;     // Position of each vertex in the heap, or -1
+	int heapSize;
+};
+
+/**
+ * Creates a workspace for running shortest path searches on graphs with
+ * the given number of vertices.
+ */
+SSSP SSSPNew(int numNodes);
+
+/**
+ * Frees all memory associated with the given workspace.
+ */
+void SSSPFree(SSSP s);
+
+/**
+ * Returns the memory SSSPNew(numNodes) allocates, counted as workspace.
+ */
+MemoryUsage SSSPMemoryEstimate(int numNodes);
+
+/**
+ * Runs Dijkstra's algorithm from 'src', filling in dist, sigma and order.
+ * If 'target' is a vertex, the search stops as soon as 'target' has been
+ * settled; the values for every settled vertex are then final. Pass -1
+ * as 'target' to settle every reachable vertex.
+ *
+ * Only the vertices touched by the previous run are reset, so a search
+ * that stops early costs time proportional to the part of the graph it
+ * explored, not the size of the graph.
+ *
+ * Exits with an error if a path count overflows a double, rather than
+ * letting it become infinite.
+ */
+void SSSPRun(SSSP s, Graph g, Vertex src, Vertex target);
+
+/**
+ * After a full SSSPRun, fills in the Brandes dependency of the source on
+ * every settled vertex v:  delta[v] is the sum over every target t of the
+ * fraction of shortest src -> t paths that pass through v. Adding delta
+ * over every source (skipping each source itself) gives betweenness.
+ * Entries for vertices that were not settled are left untouched.
+ */
+void SSSPAccumulate(SSSP s, Graph g, double *delta);
+
+/**
+ * Same as SSSPRun with no target, but only fills in dist and order. The
+ * path counts are skipped, so sigma is left as all zeros.
+ */
+void SSSPRunDistances(SSSP s, Graph g, Vertex src);
+
+/**
+ * Same as SSSPRun with no target, over a snapshot of the graph. When every
+ * edge has the same positive weight this is a breadth first search, which
+ * needs no heap.
+ */
+void SSSPRunCompact(SSSP s, CompactGraph cg, Vertex src);
+
+/**
+ * Same as SSSPAccumulate, after a SSSPRunCompact over the same snapshot.
+ */
+void SSSPAccumulateCompact(SSSP s, CompactGraph cg, double *delta);
+
+/**
+ * Same as SSSPRunDistances, over a snapshot of the graph.
+ */
+void SSSPRunDistancesCompact(SSSP s, CompactGraph cg, Vertex src);
+
+/**
+ * Starts a distance only search from 'src' that the caller drives one
+ * vertex at a time with SSSPSettleNext, so it can be abandoned early.
+ */
+void SSSPStart(SSSP s, Vertex src);
+
+/**
+ * Settles the closest queued vertex, relaxes its outgoing edges and
+ * returns it, or returns -1 if the search is finished.
+ */
+Vertex SSSPSettleNext(SSSP s, Graph g);
+
+/**
+ * Returns the smallest distance of any queued vertex, which is a lower
+ * bound on the distance of every vertex not yet settled, or INFINITY if
+ * nothing is queued.
+ */
+int SSSPFrontierDist(SSSP s);
+
+/**
+ * Returns the number of vertices that have been reached but not settled.
+ */
+int SSSPNumQueued(SSSP s);
+
+#endif
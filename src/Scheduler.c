@@ -0,0 +1,422 @@
+// Shared work stealing task scheduler implementation
+// COMP2521 Assignment 2
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Scheduler.h"
+#include "Stats.h"
+
+#define DEQUE_SIZE 64
+
+// one parallel loop, finished once every task it made has run
+typedef struct loop {
+	void (*body)(void *arg, int lo, int hi);
+	void *arg;
+	int grain;
+	atomic_int pending;
+	atomic_int queued;         // its tasks sitting in deques
+	StatsScope scope;          // what the thread that started it counts in
+} Loop;
+
+typedef struct task {
+	Loop *loop;
+	int lo;
+	int hi;
+} Task;
+
+// the owner pushes and pops at the bottom, thieves take from the top
+// a lock is enough, as tasks are at least a grain of work each
+typedef struct deque {
+	pthread_mutex_t lock;
+	Task *tasks;
+	int top;
+	int bottom;
+	int capacity;
+} Deque;
+
+typedef struct reduceJob {
+	void (*body)(void *arg, int lo, int hi, double *partial);
+	void *arg;
+	int n;
+	int grain;
+	int width;
+	double *partials;
+} ReduceJob;
+
+// deques[0] belongs to whichever outside thread holds callerLock, and
+// deques[i] to worker thread i
+static struct {
+	int requested;             // 0 for one thread per core
+	int numThreads;            // 0 until the workers are started
+	Deque *deques;
+	pthread_t *threads;
+	atomic_int queued;         // tasks sitting in deques
+	atomic_int sleepers;       // workers waiting for tasks
+	atomic_bool stopping;
+	pthread_mutex_t sleepLock;
+	pthread_cond_t wake;
+	atomic_int waiters;        // threads blocked until a loop finishes
+	pthread_mutex_t doneLock;
+	pthread_cond_t done;       // a loop finished or one of its tasks was
+	                           // queued
+	pthread_mutex_t callerLock;
+	pthread_mutex_t startLock;
+} pool = {
+	.sleepLock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.doneLock = PTHREAD_MUTEX_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+	.callerLock = PTHREAD_MUTEX_INITIALIZER,
+	.startLock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static _Thread_local bool inPool = false;
+static _Thread_local int workerId = 0;
+
+static void start(void);
+static void stop(void);
+static void *workerMain(void *arg);
+static void runTask(Task t);
+static void push(Task t);
+static void waitFor(Loop *loop);
+static void wakeWaiters(void);
+static bool popOwn(Loop *loop, Task *t);
+static bool steal(Loop *loop, Task *t);
+static void reduceBlocks(void *arg, int lo, int hi);
+
+void SchedulerSetThreads(int numThreads) {
+	pthread_mutex_lock(&pool.startLock);
+	if (pool.numThreads != 0) {
+		stop();
+	}
+	pool.requested = numThreads > 0 ? numThreads : 0;
+	pthread_mutex_unlock(&pool.startLock);
+}
+
+int SchedulerNumThreads(void) {
+	pthread_mutex_lock(&pool.startLock);
+	int numThreads = pool.requested;
+	pthread_mutex_unlock(&pool.startLock);
+	if (numThreads == 0) {
+		long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = numCores >= 1 ? (int)numCores : 1;
+	}
+	return numThreads;
+}
+
+int SchedulerWorkerId(void) {
+	return workerId;
+}
+
+// O(n / grain) tasks
+void SchedulerFor(int n, int grain, void (*body)(void *arg, int lo, int hi),
+                  void *arg) {
+	if (n <= 0) {
+		return;
+	}
+	grain = grain > 0 ? grain : 1;
+	if (n <= grain || SchedulerNumThreads() == 1) {
+		body(arg, 0, n);
+		return;
+	}
+
+	bool outside = !inPool;
+	if (outside) {
+		if (pthread_mutex_trylock(&pool.callerLock) != 0) {
+			// another outside thread has the workers
+			body(arg, 0, n);
+			return;
+		}
+		start();
+		inPool = true;
+		workerId = 0;
+	}
+
+	Loop loop;
+	loop.body = body;
+	loop.arg = arg;
+	loop.grain = grain;
+	atomic_init(&loop.pending, 1);
+	atomic_init(&loop.queued, 0);
+	loop.scope = STATS_CURRENT_SCOPE();
+	runTask((Task) {&loop, 0, n});
+	waitFor(&loop);
+
+	if (outside) {
+		inPool = false;
+		pthread_mutex_unlock(&pool.callerLock);
+	}
+}
+
+void SchedulerReduce(int n, int grain, int width, double *result,
+                     void (*body)(void *arg, int lo, int hi, double *partial),
+                     void *arg) {
+	grain = grain > 0 ? grain : 1;
+	int numBlocks = n > 0 ? (n - 1) / grain + 1 : 0;
+	ReduceJob job = {body, arg, n, grain, width, NULL};
+	job.partials = calloc((size_t)(numBlocks > 0 ? numBlocks : 1) * width,
+	                      sizeof(double));
+	if (job.partials == NULL) {
+		fprintf(stderr, "Couldn't allocate partial results!\n");
+		exit(EXIT_FAILURE);
+	}
+	SchedulerFor(numBlocks, 1, reduceBlocks, &job);
+
+	for (int i = 0; i < width; i++) {
+		result[i] = 0;
+	}
+	for (int b = 0; b < numBlocks; b++) {
+		for (int i = 0; i < width; i++) {
+			result[i] = result[i] + job.partials[(size_t)b * width + i];
+		}
+	}
+	free(job.partials);
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// starts the workers if they aren't running
+static void start(void) {
+	pthread_mutex_lock(&pool.startLock);
+	if (pool.numThreads == 0) {
+		int numThreads = pool.requested;
+		if (numThreads == 0) {
+			long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+			numThreads = numCores >= 1 ? (int)numCores : 1;
+		}
+		pool.deques = calloc(numThreads, sizeof(Deque));
+		pool.threads = malloc(numThreads * sizeof(pthread_t));
+		if (pool.deques == NULL || pool.threads == NULL) {
+			fprintf(stderr, "Couldn't allocate scheduler!\n");
+			exit(EXIT_FAILURE);
+		}
+		for (int i = 0; i < numThreads; i++) {
+			pthread_mutex_init(&pool.deques[i].lock, NULL);
+			pool.deques[i].tasks = malloc(DEQUE_SIZE * sizeof(Task));
+			pool.deques[i].capacity = DEQUE_SIZE;
+			if (pool.deques[i].tasks == NULL) {
+				fprintf(stderr, "Couldn't allocate scheduler!\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		atomic_store(&pool.queued, 0);
+		atomic_store(&pool.sleepers, 0);
+		atomic_store(&pool.stopping, false);
+		pool.numThreads = numThreads;
+		for (int i = 1; i < numThreads; i++) {
+			// workerMain reads its id from the argument
+			if (pthread_create(&pool.threads[i], NULL, workerMain,
+			                   (void *)(intptr_t)i) != 0) {
+				fprintf(stderr, "Couldn't start thread!\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	pthread_mutex_unlock(&pool.startLock);
+}
+
+// joins the workers and frees the deques, which are all empty as no loop
+// is running
+static void stop(void) {
+	pthread_mutex_lock(&pool.sleepLock);
+	atomic_store(&pool.stopping, true);
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.sleepLock);
+	for (int i = 1; i < pool.numThreads; i++) {
+		pthread_join(pool.threads[i], NULL);
+	}
+	for (int i = 0; i < pool.numThreads; i++) {
+		pthread_mutex_destroy(&pool.deques[i].lock);
+		free(pool.deques[i].tasks);
+	}
+	free(pool.deques);
+	free(pool.threads);
+	pool.numThreads = 0;
+}
+
+// runs its own tasks, then stolen ones, and sleeps when there are none
+static void *workerMain(void *arg) {
+	inPool = true;
+	workerId = (int)(intptr_t)arg;
+	while (!atomic_load(&pool.stopping)) {
+		Task t;
+		if (popOwn(NULL, &t) || steal(NULL, &t)) {
+			runTask(t);
+			continue;
+		}
+		pthread_mutex_lock(&pool.sleepLock);
+		atomic_fetch_add(&pool.sleepers, 1);
+		while (atomic_load(&pool.queued) == 0 &&
+		       !atomic_load(&pool.stopping)) {
+			pthread_cond_wait(&pool.wake, &pool.sleepLock);
+		}
+		atomic_fetch_sub(&pool.sleepers, 1);
+		pthread_mutex_unlock(&pool.sleepLock);
+	}
+	return NULL;
+}
+
+// splits off the top half of the range until it is at most a grain,
+// leaving the halves for this thread or thieves, then runs the rest
+static void runTask(Task t) {
+	Loop *loop = t.loop;
+	while (t.hi - t.lo > loop->grain) {
+		int mid = t.lo + (t.hi - t.lo) / 2;
+		atomic_fetch_add(&loop->pending, 1);
+		push((Task) {loop, mid, t.hi});
+		t.hi = mid;
+	}
+	STATS_ENTER_SCOPE(outer, loop->scope);
+	loop->body(loop->arg, t.lo, t.hi);
+	STATS_LEAVE_SCOPE(outer);
+	// the loop can be gone as soon as pending reaches 0, so it isn't
+	// touched after
+	if (atomic_fetch_sub(&loop->pending, 1) == 1) {
+		wakeWaiters();
+	}
+}
+
+// pushes onto the bottom of this thread's deque and wakes a sleeper
+// a sleeper counts itself before checking queued, and this counts the
+// task before checking sleepers, so one of them always sees the other
+static void push(Task t) {
+	Deque *d = &pool.deques[workerId];
+	pthread_mutex_lock(&d->lock);
+	if (d->bottom == d->capacity) {
+		d->capacity = 2 * d->capacity;
+		d->tasks = realloc(d->tasks, d->capacity * sizeof(Task));
+		if (d->tasks == NULL) {
+			fprintf(stderr, "Couldn't expand task deque!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	d->tasks[d->bottom++] = t;
+	atomic_fetch_add(&t.loop->queued, 1);
+	pthread_mutex_unlock(&d->lock);
+
+	atomic_fetch_add(&pool.queued, 1);
+	if (atomic_load(&pool.sleepers) > 0) {
+		pthread_mutex_lock(&pool.sleepLock);
+		pthread_cond_signal(&pool.wake);
+		pthread_mutex_unlock(&pool.sleepLock);
+	}
+	wakeWaiters();
+}
+
+// runs the loop's remaining tasks until it has finished, which is what
+// lets a body start a loop of its own, and sleeps while there are none
+// to take but some are still running elsewhere
+// a waiter counts itself before checking the loop, and push and runTask
+// change the loop before checking for waiters, so one of them always
+// sees the other
+static void waitFor(Loop *loop) {
+	while (atomic_load(&loop->pending) > 0) {
+		Task t;
+		if (popOwn(loop, &t) || steal(loop, &t)) {
+			runTask(t);
+			continue;
+		}
+		pthread_mutex_lock(&pool.doneLock);
+		atomic_fetch_add(&pool.waiters, 1);
+		while (atomic_load(&loop->pending) > 0 &&
+		       atomic_load(&loop->queued) == 0) {
+			pthread_cond_wait(&pool.done, &pool.doneLock);
+		}
+		atomic_fetch_sub(&pool.waiters, 1);
+		pthread_mutex_unlock(&pool.doneLock);
+	}
+}
+
+// wakes every thread blocked in waitFor to check its loop again
+static void wakeWaiters(void) {
+	if (atomic_load(&pool.waiters) > 0) {
+		pthread_mutex_lock(&pool.doneLock);
+		pthread_cond_broadcast(&pool.done);
+		pthread_mutex_unlock(&pool.doneLock);
+	}
+}
+
+// takes the newest task from this thread's deque, if it belongs to loop
+// (or any task for NULL)
+// a thread only waits for a loop once it has run one of its tasks, and a
+// loop started within that task has finished before it returns, so the
+// newest tasks in its deque are the loop's if it has any there
+static bool popOwn(Loop *loop, Task *t) {
+	Deque *d = &pool.deques[workerId];
+	bool found = false;
+	pthread_mutex_lock(&d->lock);
+	if (d->bottom > d->top &&
+	    (loop == NULL || d->tasks[d->bottom - 1].loop == loop)) {
+		*t = d->tasks[--d->bottom];
+		found = true;
+		atomic_fetch_sub(&t->loop->queued, 1);
+		if (d->bottom == d->top) {
+			d->top = d->bottom = 0;
+		}
+	}
+	pthread_mutex_unlock(&d->lock);
+	if (found) {
+		atomic_fetch_sub(&pool.queued, 1);
+	}
+	return found;
+}
+
+// takes the oldest task from another thread's deque, or the oldest one
+// belonging to loop unless it is NULL, trying each deque once starting
+// after this thread's own
+// another thread's deque can hold other loops' tasks older than loop's,
+// so those are looked past, and the ones above the task taken move down
+// to close the gap
+static bool steal(Loop *loop, Task *t) {
+	for (int i = 1; i < pool.numThreads; i++) {
+		Deque *d = &pool.deques[(workerId + i) % pool.numThreads];
+		bool found = false;
+		pthread_mutex_lock(&d->lock);
+		int at = d->top;
+		while (loop != NULL && at < d->bottom && d->tasks[at].loop != loop) {
+			at++;
+		}
+		if (at < d->bottom) {
+			*t = d->tasks[at];
+			found = true;
+			atomic_fetch_sub(&t->loop->queued, 1);
+			if (at == d->top) {
+				d->top++;
+			} else {
+				memmove(&d->tasks[at], &d->tasks[at + 1],
+				        (d->bottom - at - 1) * sizeof(Task));
+				d->bottom--;
+			}
+			if (d->bottom == d->top) {
+				d->top = d->bottom = 0;
+			}
+		}
+		pthread_mutex_unlock(&d->lock);
+		if (found) {
+			atomic_fetch_sub(&pool.queued, 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+// runs the body on blocks lo to hi - 1, each into its own partial
+static void reduceBlocks(void *arg, int lo, int hi) {
+	ReduceJob *job = arg;
+	for (int b = lo; b < hi; b++) {
+		int first = b * job->grain;
+		int last = job->n - first < job->grain ? job->n : first + job->grain;
+		job->body(job->arg, first, last, job->partials + (size_t)b * job->width);
+	}
+}
@@ -0,0 +1,65 @@
+// Shared work stealing task scheduler
+// COMP2521 Assignment 2
+
+// One set of worker threads shared by every parallel algorithm, so that
+// running several of them in one process doesn't start more threads than
+// there are cores. Each worker keeps its own deque of tasks: a parallel
+// loop splits its range in half, pushing one half onto the deque and
+// carrying on with the other, and idle workers steal the oldest (largest)
+// tasks from the other end of someone else's deque.
+//
+// A thread waiting for a loop to finish runs that loop's remaining tasks
+// itself, wherever they are queued, and only sleeps once there are none
+// left to take, so a loop body can start a loop of its own without
+// deadlocking. While waiting it only runs tasks from the loop it is
+// waiting for, so one thread never has two bodies of the same loop in
+// progress, and SchedulerWorkerId can be used to give each thread its own
+// scratch space.
+//
+// The workers are started by the first parallel loop and live until the
+// thread count is changed. One thread from outside the pool at a time can
+// use the workers; a loop started by another outside thread meanwhile just
+// runs on the thread that started it.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * Sets the number of threads parallel loops use, including the thread
+ * that starts them, or one per core for 0. Must not be called while a
+ * loop is running.
+ */
+void SchedulerSetThreads(int numThreads);
+
+/**
+ * Returns the number of threads parallel loops use.
+ */
+int SchedulerNumThreads(void);
+
+/**
+ * Returns the id of the calling thread, from 0 to SchedulerNumThreads() - 1.
+ * Threads outside the pool have id 0.
+ */
+int SchedulerWorkerId(void);
+
+/**
+ * Calls body(arg, lo, hi) on ranges that together cover 0 to n - 1 exactly
+ * once, in parallel, and returns once they have all finished. Ranges are
+ * split in half until they hold at most 'grain' items, so the grain should
+ * be enough work to be worth a task of its own.
+ */
+void SchedulerFor(int n, int grain, void (*body)(void *arg, int lo, int hi),
+                  void *arg);
+
+/**
+ * Splits 0 to n - 1 into blocks of 'grain' items and calls
+ * body(arg, lo, hi, partial) on each block in parallel, where partial
+ * is that block's own array of 'width' doubles, starting at 0. Sets
+ * result to the sum of the partials, added up in block order, so the
+ * result is the same whatever the number of threads.
+ */
+void SchedulerReduce(int n, int grain, int width, double *result,
+                     void (*body)(void *arg, int lo, int hi, double *partial),
+                     void *arg);
+
+#endif
@@ -0,0 +1,275 @@
+// Spectral Centrality Measures API implementation
+// COMP2521 Assignment 2
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "CentralityMeasures.h"
+#include "CentralityMeasuresExt.h"
+#include "CompactGraph.h"
+#include "Graph.h"
+#include "Scheduler.h"
+#include "SpectralCentrality.h"
+
+#define PAGERANK    1
+#define EIGENVECTOR 2
+
+// edges in each block of vertices, so small graphs don't pay for threads
+#define EDGES_PER_BLOCK 65536
+
+
+// shared by the worker threads of one iteration
+// the vertices are split into blocks by the amount of work rather than
+// by the number of threads, and each block's sums are added up in block
+// order (SchedulerReduce), so the result is the same on any number of
+// cores
+typedef struct spectralJob {
+	CompactGraph cg;  // the in-links are swept once per iteration
+	double *scale;    // what each edge's weight is multiplied by, per
+	                  // source
+	bool *dangling;   // true for vertices with no outgoing edges
+	double damping;
+
+	double *x;       // the values from the last iteration
+	double *y;       // the values being computed
+
+	int numBlocks;
+	Vertex *bounds;  // block b is vertices bounds[b] to bounds[b + 1] - 1
+
+	double base;     // PageRank: value every vertex gets before its links
+	double norm;     // eigenvector: the length of y before normalising
+} SpectralJob;
+
+static NodeValues runSpectral(Graph g, int method, double damping,
+                              double tolerance, int maxIterations);
+static void fillScales(SpectralJob *job, int method);
+static void pageRankBlocks(void *arg, int lo, int hi, double *partial);
+static void eigenvectorBlocks(void *arg, int lo, int hi, double *partial);
+static void normaliseBlocks(void *arg, int lo, int hi, double *partial);
+static void pullRows(SpectralJob *job, Vertex lo, Vertex hi, double scale,
+                     double base, double identity);
+static inline __attribute__((always_inline))
+void pullKernel(CompactGraph cg, const double *restrict weightScale,
+                const double *restrict x, double *restrict y, Vertex lo,
+                Vertex hi, double scale, double base, double identity,
+                int vertexBytes, int weightBytes);
+static void splitRows(SpectralJob *job);
+
+// O(iterations * (V + E)), split across cores on large graphs
+NodeValues pageRank(Graph g, double damping, double tolerance,
+                    int maxIterations) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	assert(damping >= 0 && damping < 1);
+	return runSpectral(g, PAGERANK, damping, tolerance, maxIterations);
+}
+
+// O(iterations * (V + E)), split across cores on large graphs
+NodeValues eigenvectorCentrality(Graph g, double tolerance,
+                                 int maxIterations) {
+	if(g == NULL) {
+		fprintf(stderr, "Invalid graph\n");
+	}
+	return runSpectral(g, EIGENVECTOR, 0, tolerance, maxIterations);
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// power iteration shared by both measures
+static NodeValues runSpectral(Graph g, int method, double damping,
+                              double tolerance, int maxIterations) {
+	int nV = GraphNumVertices(g);
+	if (nV == 0) {
+		return createNodeValues(0);
+	}
+	SpectralJob job;
+	job.cg = CompactGraphNew(g);
+	fillScales(&job, method);
+	job.damping = damping;
+	job.x = malloc(nV * sizeof(double));
+	job.y = malloc(nV * sizeof(double));
+	if (job.x == NULL || job.y == NULL) {
+		fprintf(stderr, "Couldn't allocate iteration vectors!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	double start = method == PAGERANK ? 1.0 / nV : 1 / sqrt(nV);
+	double danglingMass = 0;
+	for (Vertex v = 0; v < nV; v++) {
+		job.x[v] = start;
+		if (job.dangling[v]) {
+			danglingMass = danglingMass + start;
+		}
+	}
+	job.base = (1 - damping) / nV + damping * danglingMass / nV;
+	splitRows(&job);
+
+	// every step that needs the whole vector (the dangling mass, the norm
+	// and the convergence check) is done here between parallel passes
+	double *result = job.x;
+	for (int iteration = 0; iteration < maxIterations; iteration++) {
+		double sums[2];
+		double change;
+		if (method == PAGERANK) {
+			SchedulerReduce(job.numBlocks, 1, 2, sums, pageRankBlocks, &job);
+			change = sums[0];
+			job.base = (1 - damping) / nV + damping * sums[1] / nV;
+		} else {
+			SchedulerReduce(job.numBlocks, 1, 1, sums, eigenvectorBlocks,
+			                &job);
+			job.norm = sqrt(sums[0]);
+			SchedulerReduce(job.numBlocks, 1, 1, sums, normaliseBlocks, &job);
+			change = sums[0];
+		}
+		result = job.y;
+		double *tmp = job.x;
+		job.x = job.y;
+		job.y = tmp;
+		if (change < tolerance) {
+			break;
+		}
+	}
+
+	NodeValues nvs;
+	nvs.numNodes = nV;
+	nvs.values = result;
+	free(result == job.x ? job.y : job.x);
+	free(job.bounds);
+	free(job.scale);
+	free(job.dangling);
+	CompactGraphFree(job.cg);
+	return nvs;
+}
+
+// sets each source's multiplier to 1 / its total outgoing weight for
+// PageRank (so each vertex hands out exactly its own value), and to 1
+// for eigenvector centrality, which uses the weights as they are
+// O(V + E)
+static void fillScales(SpectralJob *job, int method) {
+	CompactGraph cg = job->cg;
+	int nV = cg->numNodes;
+	job->scale = malloc(nV * sizeof(double));
+	job->dangling = malloc(nV * sizeof(bool));
+	if (job->scale == NULL || job->dangling == NULL) {
+		fprintf(stderr, "Couldn't allocate scales!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (Vertex v = 0; v < nV; v++) {
+		double outWeight = 0;
+		for (int e = cg->outStart[v]; e < cg->outStart[v + 1]; e++) {
+			outWeight = outWeight +
+			            compactWeight(cg, cg->outWeight, cg->weightBytes, e);
+		}
+		job->dangling[v] = (outWeight == 0);
+		if (method == PAGERANK) {
+			job->scale[v] = outWeight > 0 ? 1 / outWeight : 0;
+		} else {
+			job->scale[v] = 1;
+		}
+	}
+}
+
+// one PageRank step for blocks lo to hi - 1: partial[0] is the change
+// in their values and partial[1] their new dangling mass
+static void pageRankBlocks(void *arg, int lo, int hi, double *partial) {
+	SpectralJob *job = arg;
+	for (int b = lo; b < hi; b++) {
+		Vertex first = job->bounds[b];
+		Vertex last = job->bounds[b + 1];
+		pullRows(job, first, last, job->damping, job->base, 0);
+		for (Vertex v = first; v < last; v++) {
+			partial[0] = partial[0] + fabs(job->y[v] - job->x[v]);
+			if (job->dangling[v]) {
+				partial[1] = partial[1] + job->y[v];
+			}
+		}
+	}
+}
+
+// one eigenvector step for blocks lo to hi - 1, before normalising:
+// partial[0] is the sum of the squares of their new values
+static void eigenvectorBlocks(void *arg, int lo, int hi, double *partial) {
+	SpectralJob *job = arg;
+	for (int b = lo; b < hi; b++) {
+		Vertex first = job->bounds[b];
+		Vertex last = job->bounds[b + 1];
+		pullRows(job, first, last, 1, 0, 1);
+		for (Vertex v = first; v < last; v++) {
+			partial[0] = partial[0] + job->y[v] * job->y[v];
+		}
+	}
+}
+
+// scales blocks lo to hi - 1 to unit length: partial[0] is the change in
+// their values
+static void normaliseBlocks(void *arg, int lo, int hi, double *partial) {
+	SpectralJob *job = arg;
+	for (Vertex v = job->bounds[lo]; v < job->bounds[hi]; v++) {
+		// all zero only if the graph has no vertices left to rank
+		job->y[v] = job->norm > 0 ? job->y[v] / job->norm : 0;
+		partial[0] = partial[0] + fabs(job->y[v] - job->x[v]);
+	}
+}
+
+// y[v] = base + scale * the sum over v's in-links of weight * the
+// source's multiplier * x[source], plus identity * x[v]
+static void pullRows(SpectralJob *job, Vertex lo, Vertex hi, double scale,
+                     double base, double identity) {
+	COMPACT_DISPATCH(job->cg, pullKernel, job->cg, job->scale, job->x,
+	                 job->y, lo, hi, scale, base, identity);
+}
+
+// the pull kernel, compiled once for each layout by COMPACT_DISPATCH
+// every vertex is written by exactly one thread and only reads x, so the
+// inner loop has no dependencies between iterations and can vectorise
+static inline __attribute__((always_inline))
+void pullKernel(CompactGraph cg, const double *restrict weightScale,
+                const double *restrict x, double *restrict y, Vertex lo,
+                Vertex hi, double scale, double base, double identity,
+                int vertexBytes, int weightBytes) {
+	const int *start = cg->inStart;
+	for (Vertex v = lo; v < hi; v++) {
+		double sum = 0;
+		for (int e = start[v]; e < start[v + 1]; e++) {
+			Vertex u = compactVertex(cg->inFrom, vertexBytes, e);
+			int weight = compactWeight(cg, cg->inWeight, weightBytes, e);
+			sum += weight * weightScale[u] * x[u];
+		}
+		y[v] = base + scale * sum + identity * x[v];
+	}
+}
+
+// splits the vertices into contiguous blocks with about EDGES_PER_BLOCK
+// in-links each
+static void splitRows(SpectralJob *job) {
+	int nV = job->cg->numNodes;
+	long work = (long)job->cg->inStart[nV] + nV;
+	int n = work / EDGES_PER_BLOCK + 1;
+	if (n > nV) {
+		n = nV;
+	}
+	job->numBlocks = n;
+	job->bounds = malloc((n + 1) * sizeof(Vertex));
+	if (job->bounds == NULL) {
+		fprintf(stderr, "Couldn't allocate blocks!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	Vertex v = 0;
+	job->bounds[0] = 0;
+	for (int b = 1; b < n; b++) {
+		long target = work * b / n;
+		while (v < nV && (long)job->cg->inStart[v] + v < target) {
+			v++;
+		}
+		job->bounds[b] = v;
+	}
+	job->bounds[n] = nV;
+}
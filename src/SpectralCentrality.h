@@ -0,0 +1,41 @@
+// Spectral Centrality Measures API
+// COMP2521 Assignment 2
+
+// Centrality measures defined by an eigenvector of the graph's link
+// structure rather than by shortest paths. Each iteration is a single
+// pass over the edges, so these run in O(iterations * (V + E)) instead
+// of the O(V * E log V) of closeness and betweenness.
+
+#ifndef SPECTRAL_CENTRALITY_H
+#define SPECTRAL_CENTRALITY_H
+
+#include "CentralityMeasures.h"
+#include "Graph.h"
+
+/**
+ * Finds the PageRank of each vertex and returns the results in a
+ * NodeValues structure, with the values summing to 1. A random surfer
+ * follows an outgoing edge with probability 'damping' (usually 0.85),
+ * choosing between edges in proportion to their weight, and otherwise
+ * (or when the vertex has no outgoing edges) jumps to a random vertex.
+ *
+ * Iteration stops once the values change by less than 'tolerance' in
+ * total (sum of absolute changes), or after 'maxIterations' iterations.
+ */
+NodeValues pageRank(Graph g, double damping, double tolerance,
+                    int maxIterations);
+
+/**
+ * Finds the eigenvector centrality of each vertex, where a vertex is
+ * central if central vertices have heavy edges into it, and returns the
+ * results in a NodeValues structure scaled to unit length. The iteration
+ * uses A + I in place of A, which has the same dominant eigenvector but
+ * also converges on periodic graphs.
+ *
+ * Iteration stops once the values change by less than 'tolerance' in
+ * total (sum of absolute changes), or after 'maxIterations' iterations.
+ */
+NodeValues eigenvectorCentrality(Graph g, double tolerance,
+                                 int maxIterations);
+
+#endif
@@ -0,0 +1,281 @@
+// Instrumentation counters and phase timers implementation
+// COMP2521 Assignment 2
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Stats.h"
+
+// one thread's totals, only ever written by that thread. They are atomic
+// so StatsGet can read them while the thread runs, but adding to them is
+// a plain load and store, as no other thread writes them
+// each block gets cache lines of its own, so threads don't slow each
+// other down
+typedef struct threadTotals {
+	_Alignas(64) atomic_long counts[STATS_NUM_COUNTERS];
+	atomic_long nanoseconds[STATS_NUM_PHASES];
+	struct threadTotals *prev;   // in the list of live threads
+	struct threadTotals *next;
+} ThreadTotals;
+
+// what one call has counted so far, added to by every thread running
+// part of it
+struct StatsScopeRep {
+	atomic_long counts[STATS_NUM_COUNTERS];
+	atomic_long nanoseconds[STATS_NUM_PHASES];
+	StatsScope outer;            // the scope it was started in, or NULL
+};
+
+// the totals of every thread that has counted anything, and those of the
+// threads that have since exited
+// StatsReset doesn't touch the threads' totals, which could be being
+// written, and instead remembers their sum so StatsGet can take it off
+static struct {
+	pthread_mutex_t lock;
+	pthread_once_t once;
+	pthread_key_t key;           // runs retire when a thread exits
+	ThreadTotals *live;
+	long exitedCounts[STATS_NUM_COUNTERS];
+	long exitedNanoseconds[STATS_NUM_PHASES];
+	long resetCounts[STATS_NUM_COUNTERS];
+	long resetNanoseconds[STATS_NUM_PHASES];
+} registry = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.once = PTHREAD_ONCE_INIT,
+};
+
+static _Thread_local ThreadTotals *mine = NULL;
+static _Thread_local StatsScope current = NULL;
+
+static const char *counterNames[STATS_NUM_COUNTERS] = {
+	"pqInserts", "pqUpdates", "pqDequeues", "pqScanned", "relaxations",
+	"predRebuilds", "pathSteps", "hacScans", "hacPairs", "hacMerges",
+	"hacUpdates",
+};
+
+static const char *phaseNames[STATS_NUM_PHASES] = {
+	"dijkstra", "pathCounting", "hacSearch", "hacMerge",
+};
+
+static Stats emptyStats(void);
+static void sumTotals(long *counts, long *nanoseconds);
+static ThreadTotals *join(void);
+static void createKey(void);
+static void retire(void *arg);
+static void bump(atomic_long *total, long n);
+
+// O(threads)
+Stats StatsGet(void) {
+	Stats stats = emptyStats();
+	long counts[STATS_NUM_COUNTERS];
+	long nanoseconds[STATS_NUM_PHASES];
+	pthread_mutex_lock(&registry.lock);
+	sumTotals(counts, nanoseconds);
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		stats.counts[i] = counts[i] - registry.resetCounts[i];
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		stats.seconds[i] = (nanoseconds[i] - registry.resetNanoseconds[i]) /
+		                   1e9;
+	}
+	pthread_mutex_unlock(&registry.lock);
+	return stats;
+}
+
+// O(threads)
+void StatsReset(void) {
+	pthread_mutex_lock(&registry.lock);
+	sumTotals(registry.resetCounts, registry.resetNanoseconds);
+	pthread_mutex_unlock(&registry.lock);
+}
+
+StatsScope StatsBegin(void) {
+	StatsScope scope = calloc(1, sizeof(*scope));
+	if (scope == NULL) {
+		fprintf(stderr, "Couldn't allocate stats scope!\n");
+		exit(EXIT_FAILURE);
+	}
+	scope->outer = current;
+	current = scope;
+	return scope;
+}
+
+// the loops the scope's call started have all finished by the time it
+// ends, so nothing else is still adding to it
+Stats StatsEnd(StatsScope scope) {
+	Stats stats = emptyStats();
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		stats.counts[i] = atomic_load(&scope->counts[i]);
+		if (scope->outer != NULL) {
+			atomic_fetch_add(&scope->outer->counts[i], stats.counts[i]);
+		}
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		long nanoseconds = atomic_load(&scope->nanoseconds[i]);
+		stats.seconds[i] = nanoseconds / 1e9;
+		if (scope->outer != NULL) {
+			atomic_fetch_add(&scope->outer->nanoseconds[i], nanoseconds);
+		}
+	}
+	current = scope->outer;
+	free(scope);
+	return stats;
+}
+
+void StatsShow(Stats stats) {
+	if (!stats.enabled) {
+		printf("stats: not compiled in (build with -DGRAPH_STATS)\n");
+		return;
+	}
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		printf("%-14s %ld\n", counterNames[i], stats.counts[i]);
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		printf("%-14s %.6f s\n", phaseNames[i], stats.seconds[i]);
+	}
+}
+
+const char *StatsCounterName(StatsCounter counter) {
+	return counterNames[counter];
+}
+
+const char *StatsPhaseName(StatsPhase phase) {
+	return phaseNames[phase];
+}
+
+// relaxed: the totals are only read once the work being measured is done
+void statsAdd(StatsCounter counter, long n) {
+	ThreadTotals *t = mine != NULL ? mine : join();
+	bump(&t->counts[counter], n);
+	if (current != NULL) {
+		atomic_fetch_add_explicit(&current->counts[counter], n,
+		                          memory_order_relaxed);
+	}
+}
+
+void statsAddTime(StatsPhase phase, double seconds) {
+	ThreadTotals *t = mine != NULL ? mine : join();
+	long nanoseconds = (long)(seconds * 1e9);
+	bump(&t->nanoseconds[phase], nanoseconds);
+	if (current != NULL) {
+		atomic_fetch_add_explicit(&current->nanoseconds[phase], nanoseconds,
+		                          memory_order_relaxed);
+	}
+}
+
+double statsNow(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+StatsScope statsCurrentScope(void) {
+	return current;
+}
+
+StatsScope statsSwapScope(StatsScope scope) {
+	StatsScope old = current;
+	current = scope;
+	return old;
+}
+
+// ========================
+// === HELPER FUNCTIONS ===
+// ========================
+
+// totals of 0, marked with whether counting is compiled in
+static Stats emptyStats(void) {
+	Stats stats = {0};
+#ifdef GRAPH_STATS
+	stats.enabled = true;
+#else
+	stats.enabled = false;
+#endif
+	return stats;
+}
+
+// adds up the totals of every thread, live or exited, since the start
+// the registry lock must be held
+static void sumTotals(long *counts, long *nanoseconds) {
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		counts[i] = registry.exitedCounts[i];
+		for (ThreadTotals *t = registry.live; t != NULL; t = t->next) {
+			counts[i] = counts[i] + atomic_load_explicit(&t->counts[i],
+			                                             memory_order_relaxed);
+		}
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		nanoseconds[i] = registry.exitedNanoseconds[i];
+		for (ThreadTotals *t = registry.live; t != NULL; t = t->next) {
+			nanoseconds[i] = nanoseconds[i] +
+			                 atomic_load_explicit(&t->nanoseconds[i],
+			                                      memory_order_relaxed);
+		}
+	}
+}
+
+// gives the calling thread totals of its own, the first time it counts
+static ThreadTotals *join(void) {
+	pthread_once(&registry.once, createKey);
+	ThreadTotals *t = aligned_alloc(64, sizeof(ThreadTotals));
+	if (t == NULL) {
+		fprintf(stderr, "Couldn't allocate stats totals!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		atomic_init(&t->counts[i], 0);
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		atomic_init(&t->nanoseconds[i], 0);
+	}
+	pthread_mutex_lock(&registry.lock);
+	t->prev = NULL;
+	t->next = registry.live;
+	if (registry.live != NULL) {
+		registry.live->prev = t;
+	}
+	registry.live = t;
+	pthread_mutex_unlock(&registry.lock);
+	pthread_setspecific(registry.key, t);
+	mine = t;
+	return t;
+}
+
+static void createKey(void) {
+	pthread_key_create(&registry.key, retire);
+}
+
+// moves an exiting thread's totals into the exited totals
+static void retire(void *arg) {
+	ThreadTotals *t = arg;
+	pthread_mutex_lock(&registry.lock);
+	for (int i = 0; i < STATS_NUM_COUNTERS; i++) {
+		registry.exitedCounts[i] = registry.exitedCounts[i] +
+		                           atomic_load(&t->counts[i]);
+	}
+	for (int i = 0; i < STATS_NUM_PHASES; i++) {
+		registry.exitedNanoseconds[i] = registry.exitedNanoseconds[i] +
+		                                atomic_load(&t->nanoseconds[i]);
+	}
+	if (t->prev != NULL) {
+		t->prev->next = t->next;
+	} else {
+		registry.live = t->next;
+	}
+	if (t->next != NULL) {
+		t->next->prev = t->prev;
+	}
+	pthread_mutex_unlock(&registry.lock);
+	free(t);
+}
+
+// adds n to a total only this thread writes
+static void bump(atomic_long *total, long n) {
+	long value = atomic_load_explicit(total, memory_order_relaxed);
+	atomic_store_explicit(total, value + n, memory_order_relaxed);
+}
@@ -0,0 +1,121 @@
+// Instrumentation counters and phase timers
+// COMP2521 Assignment 2
+
+// Compile every file with -DGRAPH_STATS to count the work done on the hot
+// paths (priority queue operations, edge relaxations, path counting and
+// the HAC search and merges) and time the phases they belong to. Without
+// it the STATS_* macros expand to nothing, so the arguments are never
+// evaluated and the instrumented code is exactly what it was.
+//
+// Each thread counts into totals of its own, which StatsGet adds up, so
+// counting never makes threads wait for each other. The totals cover
+// everything done in the process since StatsReset. To count one call on
+// its own, even while other calls run at the same time, put it between
+// StatsBegin and StatsEnd: the scope follows the call into the tasks of
+// any parallel loop it starts, whichever thread runs them. Phase times
+// are summed over the threads that ran the phase, so on several cores
+// they can exceed the wall clock time.
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+
+typedef enum {
+	STATS_PQ_INSERTS,       // PQInsert calls
+	STATS_PQ_UPDATES,       // PQUpdate calls (including from PQInsert)
+	STATS_PQ_DEQUEUES,      // PQDequeue calls
+	STATS_PQ_SCANNED,       // items looked at by all of the above
+	STATS_RELAXATIONS,      // edges relaxed by dijkstra and SSSP
+	STATS_PRED_REBUILDS,    // predecessor lists replaced by a shorter path
+	STATS_PATH_STEPS,       // predecessors summed while counting paths
+	STATS_HAC_SCANS,        // closest pair searches over the matrix
+	STATS_HAC_PAIRS,        // pairs looked at by those searches
+	STATS_HAC_MERGES,       // merges applied to the distance matrix
+	STATS_HAC_UPDATES,      // distances recomputed by those merges
+	STATS_NUM_COUNTERS
+} StatsCounter;
+
+typedef enum {
+	STATS_DIJKSTRA,         // dijkstra
+	STATS_PATH_COUNTING,    // counting shortest paths for betweenness
+	STATS_HAC_SEARCH,       // HAC closest pair searches
+	STATS_HAC_MERGE,        // HAC merges
+	STATS_NUM_PHASES
+} StatsPhase;
+
+typedef struct Stats {
+	bool enabled;                        // false if compiled without
+	                                     // GRAPH_STATS, when every
+	                                     // total is 0
+	long counts[STATS_NUM_COUNTERS];     // indexed by StatsCounter
+	double seconds[STATS_NUM_PHASES];    // indexed by StatsPhase
+} Stats;
+
+typedef struct StatsScopeRep *StatsScope;
+
+/**
+ * Returns the totals counted since the last reset.
+ */
+Stats StatsGet(void);
+
+/**
+ * Sets every total back to 0.
+ */
+void StatsReset(void);
+
+/**
+ * Starts counting the work the calling thread does until StatsEnd, along
+ * with the tasks of the parallel loops it starts. Scopes can be nested,
+ * and what an inner scope counts is counted in the outer one too.
+ */
+StatsScope StatsBegin(void);
+
+/**
+ * Ends a scope started by StatsBegin on the same thread, frees it and
+ * returns what it counted.
+ */
+Stats StatsEnd(StatsScope scope);
+
+/**
+ * Prints the given totals to stdout, one per line.
+ */
+void StatsShow(Stats stats);
+
+/**
+ * The names StatsShow prints for a counter and a phase.
+ */
+const char *StatsCounterName(StatsCounter counter);
+const char *StatsPhaseName(StatsPhase phase);
+
+// Used by the macros below
+void statsAdd(StatsCounter counter, long n);
+void statsAddTime(StatsPhase phase, double seconds);
+double statsNow(void);
+StatsScope statsCurrentScope(void);
+StatsScope statsSwapScope(StatsScope scope);
+
+#ifdef GRAPH_STATS
+// adds n to a counter
+#define STATS_ADD(counter, n)          statsAdd((counter), (n))
+// starts a timer, declared as a local variable called name
+#define STATS_TIMER(name)              double name = statsNow()
+// adds the time since STATS_TIMER(name) to a phase
+#define STATS_TIMER_STOP(name, phase)  statsAddTime((phase), statsNow() - (name))
+// the calling thread's scope, for handing on to the threads that help it
+#define STATS_CURRENT_SCOPE()          statsCurrentScope()
+// makes scope the calling thread's, keeping the old one in a local called
+// name
+#define STATS_ENTER_SCOPE(name, scope) StatsScope name = statsSwapScope(scope)
+// goes back to the scope kept by STATS_ENTER_SCOPE(name, ...)
+#define STATS_LEAVE_SCOPE(name)        statsSwapScope(name)
+#else
+#define STATS_ADD(counter, n)          ((void)0)
+#define STATS_TIMER(name)              ((void)0)
+#define STATS_TIMER_STOP(name, phase)  ((void)0)
+#define STATS_CURRENT_SCOPE()          NULL
+#define STATS_ENTER_SCOPE(name, scope) ((void)0)
+#define STATS_LEAVE_SCOPE(name)        ((void)0)
+#endif
+
+#endif
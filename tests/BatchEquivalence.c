@@ -0,0 +1,261 @@
+// Checks GraphBatchApply against making the same changes one at a time
+// COMP2521 Assignment 2
+
+// Random batches of insertions, removals and weight changes (with many
+// repeats of the same edge) are applied to one graph, and made one at a
+// time with GraphInsertEdge/GraphRemoveEdge to another. After each batch
+// the two graphs' out- and in-lists must be the same, and the vertices
+// the batch reports as touched must be exactly those whose lists changed.
+// A batch with an invalid change must be refused with the graph left as
+// it was, and a reader holding GraphReadLock must never see part of a
+// batch.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Graph.h"
+#include "GraphExt.h"
+
+#define READER_BATCH 1024
+
+typedef struct reader {
+	Graph g;
+	atomic_bool stop;
+	bool ok;
+} Reader;
+
+static bool runCase(int nV, int numBatches, int batchSize, int maxWeight);
+static void applySingly(Graph g, Vertex src, Vertex dest, int weight,
+                        int kind);
+static bool sameLists(AdjList x, AdjList y);
+static bool sameGraph(Graph x, Graph y, int batch);
+static bool checkTouched(Graph before, Graph after, GraphBatch b, int count,
+                         int batch);
+static Graph copyGraph(Graph g);
+static bool checkInvalid(void);
+static bool checkReader(void);
+static void *readEdges(void *arg);
+static int countEdges(Graph g);
+
+int main(void) {
+	srand(2521);
+	bool ok = true;
+	ok = runCase(5, 300, 20, 3) && ok;
+	ok = runCase(40, 200, 200, 9) && ok;
+	ok = runCase(300, 50, 3000, 50) && ok;
+	ok = checkInvalid() && ok;
+	ok = checkReader() && ok;
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+	printf("BatchEquivalence: ok\n");
+	return EXIT_SUCCESS;
+}
+
+// applies numBatches random batches to one graph and the same changes one
+// at a time to another, comparing them after each batch
+static bool runCase(int nV, int numBatches, int batchSize, int maxWeight) {
+	Graph batched = GraphNew(nV);
+	Graph single = GraphNew(nV);
+	GraphBatch b = GraphBatchNew();
+	bool ok = true;
+	for (int batch = 0; batch < numBatches && ok; batch++) {
+		Graph before = copyGraph(batched);
+		// a small range of vertices makes the same edge come up often
+		int range = 1 + rand() % nV;
+		for (int i = 0; i < batchSize; i++) {
+			Vertex src = rand() % range;
+			Vertex dest = rand() % range;
+			int weight = 1 + rand() % maxWeight;
+			int kind = rand() % 3;
+			if (kind == 0) {
+				GraphBatchInsertEdge(b, src, dest, weight);
+			} else if (kind == 1) {
+				GraphBatchRemoveEdge(b, src, dest);
+			} else {
+				GraphBatchUpdateWeight(b, src, dest, weight);
+			}
+			applySingly(single, src, dest, weight, kind);
+		}
+		int count = GraphBatchApply(batched, b);
+		ok = sameGraph(single, batched, batch) &&
+		     checkTouched(before, batched, b, count, batch);
+		GraphFree(before);
+	}
+	GraphBatchFree(b);
+	GraphFree(batched);
+	GraphFree(single);
+	return ok;
+}
+
+// makes one change with the single edge operations of Graph.h
+static void applySingly(Graph g, Vertex src, Vertex dest, int weight,
+                        int kind) {
+	if (kind == 0) {
+		GraphInsertEdge(g, src, dest, weight);
+	} else if (kind == 1) {
+		GraphRemoveEdge(g, src, dest);
+	} else if (GraphIsAdjacent(g, src, dest)) {
+		GraphRemoveEdge(g, src, dest);
+		GraphInsertEdge(g, src, dest, weight);
+	}
+}
+
+static bool sameLists(AdjList x, AdjList y) {
+	for (; x != NULL && y != NULL; x = x->next, y = y->next) {
+		if (x->v != y->v || x->weight != y->weight) {
+			return false;
+		}
+	}
+	return x == NULL && y == NULL;
+}
+
+static bool sameGraph(Graph x, Graph y, int batch) {
+	for (Vertex v = 0; v < GraphNumVertices(x); v++) {
+		if (!sameLists(GraphOutIncident(x, v), GraphOutIncident(y, v)) ||
+		    !sameLists(GraphInIncident(x, v), GraphInIncident(y, v))) {
+			printf("BatchEquivalence: lists of %d differ after batch %d\n",
+			       v, batch);
+			return false;
+		}
+	}
+	return true;
+}
+
+// the touched vertices must be those whose out- or in-list changed, in
+// increasing order
+static bool checkTouched(Graph before, Graph after, GraphBatch b, int count,
+                         int batch) {
+	const Vertex *touched = GraphBatchTouched(b);
+	int j = 0;
+	for (Vertex v = 0; v < GraphNumVertices(after); v++) {
+		bool changed =
+			!sameLists(GraphOutIncident(before, v), GraphOutIncident(after, v)) ||
+			!sameLists(GraphInIncident(before, v), GraphInIncident(after, v));
+		bool listed = j < count && touched[j] == v;
+		if (changed != listed) {
+			printf("BatchEquivalence: %d is%s listed as touched after batch "
+			       "%d\n", v, listed ? "" : " not", batch);
+			return false;
+		}
+		j += listed;
+	}
+	if (j != count) {
+		printf("BatchEquivalence: batch %d reports %d touched, expected %d\n",
+		       batch, count, j);
+		return false;
+	}
+	return true;
+}
+
+static Graph copyGraph(Graph g) {
+	Graph copy = GraphNew(GraphNumVertices(g));
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList out = GraphOutIncident(g, v); out != NULL;
+		     out = out->next) {
+			GraphInsertEdge(copy, v, out->v, out->weight);
+		}
+	}
+	return copy;
+}
+
+// every kind of invalid change must be refused before anything changes,
+// even with valid changes ahead of it in the batch
+static bool checkInvalid(void) {
+	Graph g = GraphNew(4);
+	GraphInsertEdge(g, 0, 1, 5);
+	Graph before = copyGraph(g);
+	GraphBatch b = GraphBatchNew();
+	bool ok = true;
+	for (int bad = 0; bad < 5 && ok; bad++) {
+		GraphBatchRemoveEdge(b, 0, 1);
+		GraphBatchInsertEdge(b, 2, 3, 1);
+		if (bad == 0) {
+			GraphBatchInsertEdge(b, 0, 4, 1);
+		} else if (bad == 1) {
+			GraphBatchRemoveEdge(b, -1, 2);
+		} else if (bad == 2) {
+			GraphBatchInsertEdge(b, 1, 2, 0);
+		} else if (bad == 3) {
+			GraphBatchUpdateWeight(b, 2, 3, -7);
+		} else {
+			GraphBatchUpdateWeight(b, 4, 0, 1);
+		}
+		if (GraphBatchApply(g, b) != -1 || !sameGraph(before, g, bad)) {
+			printf("BatchEquivalence: invalid batch %d was applied\n", bad);
+			ok = false;
+		}
+		GraphBatchFree(b);
+		b = GraphBatchNew();
+	}
+	GraphBatchFree(b);
+	GraphFree(before);
+	GraphFree(g);
+	return ok;
+}
+
+// batches of READER_BATCH new edges are applied while another thread
+// counts the edges under the read lock, which must always be a whole
+// number of batches
+static bool checkReader(void) {
+	int nV = 256;
+	Reader r = {GraphNew(nV), false, true};
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, readEdges, &r) != 0) {
+		fprintf(stderr, "Couldn't start reader thread!\n");
+		exit(EXIT_FAILURE);
+	}
+	GraphBatch b = GraphBatchNew();
+	for (int round = 0; round < 300; round++) {
+		for (int i = 0; i < READER_BATCH; i++) {
+			int e = (round * READER_BATCH + i) % (nV * nV);
+			if (round * READER_BATCH + i < nV * nV) {
+				GraphBatchInsertEdge(b, e / nV, e % nV, 1);
+			} else {
+				GraphBatchUpdateWeight(b, e / nV, e % nV, 1 + round);
+			}
+		}
+		GraphBatchApply(r.g, b);
+	}
+	atomic_store(&r.stop, true);
+	pthread_join(thread, NULL);
+	GraphBatchFree(b);
+	GraphFree(r.g);
+	if (!r.ok) {
+		printf("BatchEquivalence: a reader saw part of a batch\n");
+	}
+	return r.ok;
+}
+
+static void *readEdges(void *arg) {
+	Reader *r = arg;
+	while (!atomic_load(&r->stop)) {
+		GraphReadLock(r->g);
+		int count = countEdges(r->g);
+		GraphReadUnlock(r->g);
+		if (count % READER_BATCH != 0) {
+			r->ok = false;
+		}
+	}
+	return NULL;
+}
+
+// counts the out-list edges, and the in-list edges, which must match
+static int countEdges(Graph g) {
+	int numOut = 0;
+	int numIn = 0;
+	for (Vertex v = 0; v < GraphNumVertices(g); v++) {
+		for (AdjList l = GraphOutIncident(g, v); l != NULL; l = l->next) {
+			numOut++;
+		}
+		for (AdjList l = GraphInIncident(g, v); l != NULL; l = l->next) {
+			numIn++;
+		}
+	}
+	return numOut == numIn ? numOut : -1;
+}
@@ -0,0 +1,102 @@
+// Checks the C++ graph core against the C centrality measures
+// COMP2521 Assignment 2
+
+// Random graphs are built with the C Graph ADT and taken into
+// graphcore::Graph with narrow (16 bit), 32 bit and 64 bit vertex ids,
+// and with Unit weights when every edge weighs 1. closeness and
+// betweenness must give what closenessCentrality and
+// betweennessCentrality give.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "GraphCore.hpp"
+
+extern "C" {
+#include "CentralityMeasures.h"
+#include "Graph.h"
+}
+
+#define TOLERANCE 1e-9
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight);
+static bool sameValues(NodeValues expected, const std::vector<double> &got,
+                       const char *what, const char *types);
+template <typename VertexT, typename WeightT>
+static bool checkCore(Graph g, const char *types);
+
+int main(void) {
+	srand(2521);
+	bool ok = true;
+	for (int i = 0; i < 200 && ok; i++) {
+		int nV = 1 + rand() % 60;
+		int numEdges = rand() % (4 * nV + 1);
+		Graph g = randomGraph(nV, numEdges, 1 + rand() % 200);
+		ok = checkCore<std::uint16_t, std::uint8_t>(g, "uint16_t, uint8_t");
+		ok = ok && checkCore<std::uint32_t, std::uint32_t>(g,
+		                                                   "uint32_t, uint32_t");
+		ok = ok && checkCore<std::uint64_t, std::uint16_t>(g,
+		                                                   "uint64_t, uint16_t");
+		GraphFree(g);
+
+		g = randomGraph(nV, numEdges, 1);
+		ok = ok && checkCore<std::uint16_t, graphcore::Unit>(g,
+		                                                     "uint16_t, Unit");
+		ok = ok && checkCore<std::uint64_t, graphcore::Unit>(g,
+		                                                     "uint64_t, Unit");
+		GraphFree(g);
+	}
+
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+	printf("GraphCoreEquivalence: ok\n");
+	return EXIT_SUCCESS;
+}
+
+template <typename VertexT, typename WeightT>
+static bool checkCore(Graph g, const char *types) {
+	graphcore::Graph<VertexT, WeightT> core =
+		graphcore::fromGraph<VertexT, WeightT>(g);
+
+	NodeValues expected = closenessCentrality(g);
+	bool ok = sameValues(expected, graphcore::closeness(core), "closeness",
+	                     types);
+	freeNodeValues(expected);
+
+	expected = betweennessCentrality(g);
+	ok = sameValues(expected, graphcore::betweenness(core), "betweenness",
+	                types) && ok;
+	freeNodeValues(expected);
+	return ok;
+}
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight) {
+	Graph g = GraphNew(nV);
+	for (int i = 0; i < numEdges; i++) {
+		Vertex src = rand() % nV;
+		Vertex dest = rand() % nV;
+		if (src != dest) {
+			GraphInsertEdge(g, src, dest, 1 + rand() % maxWeight);
+		}
+	}
+	return g;
+}
+
+static bool sameValues(NodeValues expected, const std::vector<double> &got,
+                       const char *what, const char *types) {
+	for (int v = 0; v < expected.numNodes; v++) {
+		double scale = std::fabs(expected.values[v]) > 1 ?
+		               std::fabs(expected.values[v]) : 1;
+		if (std::fabs(expected.values[v] - got[v]) > TOLERANCE * scale) {
+			printf("GraphCoreEquivalence: %s of %d with <%s> is %.17g, "
+			       "expected %.17g\n", what, v, types, got[v],
+			       expected.values[v]);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,78 @@
+// Checks that dense and sparse clustering give the same linkage
+// COMP2521 Assignment 2
+
+// LanceWilliamsLinkage finds its merges with the distance matrix (or the
+// spanning forest for single linkage) when 'sparse' is false, and with
+// per cluster maps of the finite distances when it is true. Both must
+// give the same rows in the same order. Small weights make many distances
+// equal, so the ties between pairs are what is really being checked.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Graph.h"
+#include "LanceWilliamsHAC.h"
+#include "LanceWilliamsHACExt.h"
+
+#define NUM_GRAPHS 2000
+#define TOLERANCE 1e-12
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight);
+static bool sameRows(Linkage dense, Linkage sparse, int method, int graph);
+
+int main(void) {
+	srand(2521);
+	bool ok = true;
+	for (int graph = 0; graph < NUM_GRAPHS && ok; graph++) {
+		int nV = 2 + rand() % 12;
+		int maxWeight = 1 + rand() % 3;
+		Graph g = randomGraph(nV, rand() % (nV * nV), maxWeight);
+		for (int method = SINGLE_LINKAGE; method <= MEDIAN_LINKAGE && ok;
+		     method++) {
+			Linkage dense = LanceWilliamsLinkage(g, method, false);
+			Linkage sparse = LanceWilliamsLinkage(g, method, true);
+			ok = sameRows(dense, sparse, method, graph);
+			freeLinkage(dense);
+			freeLinkage(sparse);
+		}
+		GraphFree(g);
+	}
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+	printf("HACEquivalence: ok\n");
+	return EXIT_SUCCESS;
+}
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight) {
+	Graph g = GraphNew(nV);
+	for (int i = 0; i < numEdges; i++) {
+		Vertex src = rand() % nV;
+		Vertex dest = rand() % nV;
+		if (src != dest) {
+			GraphInsertEdge(g, src, dest, 1 + rand() % maxWeight);
+		}
+	}
+	return g;
+}
+
+static bool sameRows(Linkage dense, Linkage sparse, int method, int graph) {
+	for (int r = 0; r < dense.numVertices - 1; r++) {
+		LinkageRow d = dense.rows[r];
+		LinkageRow s = sparse.rows[r];
+		bool sameDistance = d.distance == s.distance ||
+		                    fabs(d.distance - s.distance) <=
+		                    TOLERANCE * fabs(d.distance);
+		if (d.left != s.left || d.right != s.right || d.size != s.size ||
+		    !sameDistance) {
+			printf("HACEquivalence: graph %d, method %d, row %d is "
+			       "(%d, %d, %g, %d) dense but (%d, %d, %g, %d) sparse\n",
+			       graph, method, r, d.left, d.right, d.distance, d.size,
+			       s.left, s.right, s.distance, s.size);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,168 @@
+// Checks IncCentrality against computing the measures from scratch
+// COMP2521 Assignment 2
+
+// Random edges are inserted and removed through the engine, and after
+// every change its closeness and betweenness must match what
+// closenessCentrality and betweennessCentrality give for the graph as it
+// is then. The long run on a small graph catches error building up over
+// many updates. On a chain of diamonds with more shortest paths than a
+// double holds, the engine must exit with an error (checked in a child
+// process) rather than keep NaN betweenness.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CentralityMeasures.h"
+#include "Graph.h"
+#include "IncrementalCentrality.h"
+
+#define TOLERANCE 1e-9
+// 2^1030 shortest paths from the top of the chain to its bottom
+#define NUM_DIAMONDS 1030
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight);
+static bool sameValues(NodeValues expected, NodeValues got, const char *what,
+                       int step);
+static bool runCase(int nV, int numEdges, int maxWeight, int numUpdates,
+                    bool compress);
+static bool overflowFails(void);
+
+int main(void) {
+	srand(2521);
+	bool ok = true;
+	ok = runCase(8, 12, 3, 200, false) && ok;
+	ok = runCase(30, 60, 1, 300, true) && ok;
+	ok = runCase(40, 120, 9, 300, false) && ok;
+	ok = runCase(12, 30, 2, 3000, true) && ok;
+	ok = overflowFails() && ok;
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+	printf("IncrementalEquivalence: ok\n");
+	return EXIT_SUCCESS;
+}
+
+// applies numUpdates random inserts and removes, checking after each
+static bool runCase(int nV, int numEdges, int maxWeight, int numUpdates,
+                    bool compress) {
+	Graph g = randomGraph(nV, numEdges, maxWeight);
+	IncCentrality ic = IncCentralityNew(g, compress);
+	bool ok = true;
+	for (int step = 0; step < numUpdates && ok; step++) {
+		Vertex src = rand() % nV;
+		Vertex dest = rand() % nV;
+		if (src == dest) {
+			continue;
+		}
+		if (rand() % 2 == 0) {
+			IncCentralityInsertEdge(ic, src, dest, 1 + rand() % maxWeight);
+		} else {
+			IncCentralityRemoveEdge(ic, src, dest);
+		}
+
+		NodeValues expected = closenessCentrality(g);
+		NodeValues got = IncCentralityCloseness(ic);
+		ok = sameValues(expected, got, "closeness", step);
+		freeNodeValues(expected);
+		freeNodeValues(got);
+
+		expected = betweennessCentrality(g);
+		got = IncCentralityBetweenness(ic);
+		ok = sameValues(expected, got, "betweenness", step) && ok;
+		freeNodeValues(expected);
+		freeNodeValues(got);
+	}
+	IncCentralityFree(ic);
+	GraphFree(g);
+	return ok;
+}
+
+// builds the engine on a chain of diamonds in a child process, with its
+// stderr read back through a pipe, and returns whether it failed with the
+// overflow error
+static bool overflowFails(void) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		fprintf(stderr, "Couldn't create pipe!\n");
+		exit(EXIT_FAILURE);
+	}
+	fflush(stdout);
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "Couldn't fork!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (child == 0) {
+		close(fds[0]);
+		dup2(fds[1], STDERR_FILENO);
+		// diamond i is 3i -> 3i + 1, 3i + 2 -> 3i + 3
+		Graph g = GraphNew(3 * NUM_DIAMONDS + 1);
+		for (int i = 0; i < NUM_DIAMONDS; i++) {
+			Vertex top = 3 * i;
+			GraphInsertEdge(g, top, top + 1, 1);
+			GraphInsertEdge(g, top, top + 2, 1);
+			GraphInsertEdge(g, top + 1, top + 3, 1);
+			GraphInsertEdge(g, top + 2, top + 3, 1);
+		}
+		IncCentrality ic = IncCentralityNew(g, false);
+		NodeValues nvs = IncCentralityBetweenness(ic);
+		freeNodeValues(nvs);
+		IncCentralityFree(ic);
+		GraphFree(g);
+		exit(EXIT_SUCCESS);
+	}
+
+	close(fds[1]);
+	char message[256] = {0};
+	size_t length = 0;
+	ssize_t got;
+	while ((got = read(fds[0], message + length,
+	                   sizeof(message) - 1 - length)) > 0) {
+		length += got;
+	}
+	close(fds[0]);
+	int status;
+	waitpid(child, &status, 0);
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_FAILURE ||
+	    strstr(message, "Shortest path count overflowed") == NULL) {
+		printf("IncrementalEquivalence: overflowing path counts didn't fail "
+		       "with the overflow error (stderr: \"%s\")\n", message);
+		return false;
+	}
+	return true;
+}
+
+static Graph randomGraph(int nV, int numEdges, int maxWeight) {
+	Graph g = GraphNew(nV);
+	for (int i = 0; i < numEdges; i++) {
+		Vertex src = rand() % nV;
+		Vertex dest = rand() % nV;
+		if (src != dest) {
+			GraphInsertEdge(g, src, dest, 1 + rand() % maxWeight);
+		}
+	}
+	return g;
+}
+
+static bool sameValues(NodeValues expected, NodeValues got, const char *what,
+                       int step) {
+	for (int v = 0; v < expected.numNodes; v++) {
+		double scale = fabs(expected.values[v]) > 1 ?
+		               fabs(expected.values[v]) : 1;
+		if (fabs(expected.values[v] - got.values[v]) > TOLERANCE * scale) {
+			printf("IncrementalEquivalence: %s of %d after update %d is "
+			       "%.17g, expected %.17g\n", what, v, step, got.values[v],
+			       expected.values[v]);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,110 @@
+// Checks that betweenness stops on path counts too big for a double
+// COMP2521 Assignment 2
+
+// A chain of 1030 diamonds has 2^1030 shortest paths from its top to its
+// bottom, more than a double holds. Rather than return infinite path
+// counts, which turn the dependencies into NaN, every betweenness
+// function must exit with an error. Each is run in a child process, which
+// must fail with "Shortest path count overflowed" on stderr.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CentralityMeasures.h"
+#include "CentralityMeasuresExt.h"
+#include "Graph.h"
+
+#define NUM_DIAMONDS 1030
+
+static Graph diamondChain(int numDiamonds);
+static bool failsWithOverflow(void (*run)(Graph g), Graph g,
+                              const char *what);
+static void runBetweenness(Graph g);
+static void runComputeCentralities(Graph g);
+
+int main(void) {
+	Graph g = diamondChain(NUM_DIAMONDS);
+	bool ok = true;
+	ok = failsWithOverflow(runBetweenness, g, "betweennessCentrality") && ok;
+	ok = failsWithOverflow(runComputeCentralities, g,
+	                       "computeCentralities") && ok;
+	GraphFree(g);
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+	printf("PathCountOverflow: ok\n");
+	return EXIT_SUCCESS;
+}
+
+// the top of diamond i is 3i, its sides 3i + 1 and 3i + 2, and its bottom
+// the top of the next one
+static Graph diamondChain(int numDiamonds) {
+	Graph g = GraphNew(3 * numDiamonds + 1);
+	for (int i = 0; i < numDiamonds; i++) {
+		Vertex top = 3 * i;
+		GraphInsertEdge(g, top, top + 1, 1);
+		GraphInsertEdge(g, top, top + 2, 1);
+		GraphInsertEdge(g, top + 1, top + 3, 1);
+		GraphInsertEdge(g, top + 2, top + 3, 1);
+	}
+	return g;
+}
+
+// runs run(g) in a child process, with its stderr read back through a
+// pipe, and returns whether it failed with the overflow error
+static bool failsWithOverflow(void (*run)(Graph g), Graph g,
+                              const char *what) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		fprintf(stderr, "Couldn't create pipe!\n");
+		exit(EXIT_FAILURE);
+	}
+	fflush(stdout);
+	pid_t child = fork();
+	if (child < 0) {
+		fprintf(stderr, "Couldn't fork!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (child == 0) {
+		close(fds[0]);
+		dup2(fds[1], STDERR_FILENO);
+		run(g);
+		exit(EXIT_SUCCESS);
+	}
+
+	close(fds[1]);
+	char message[256] = {0};
+	size_t length = 0;
+	ssize_t got;
+	while ((got = read(fds[0], message + length,
+	                   sizeof(message) - 1 - length)) > 0) {
+		length += got;
+	}
+	close(fds[0]);
+	int status;
+	waitpid(child, &status, 0);
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_FAILURE ||
+	    strstr(message, "Shortest path count overflowed") == NULL) {
+		printf("PathCountOverflow: %s didn't fail with the overflow error "
+		       "(stderr: \"%s\")\n", what, message);
+		return false;
+	}
+	return true;
+}
+
+static void runBetweenness(Graph g) {
+	NodeValues nvs = betweennessCentrality(g);
+	freeNodeValues(nvs);
+}
+
+static void runComputeCentralities(Graph g) {
+	Centralities c = computeCentralities(g, CENTRALITY_ALL);
+	freeCentralities(c);
+}